@@ -0,0 +1,46 @@
+#ifndef _BRESENHAM_H_
+#define _BRESENHAM_H_
+
+#include <inttypes.h>
+#include <avr/pgmspace.h>
+#include "bjorklund.h"
+#include "phases.h"
+
+/**
+   Computes the Bjorklund patterns with the error term of a Bresenham
+   line instead of the recursion: step i of E(k,n) has a pulse if and
+   only if (p + i * k) mod n < k. The start phase p has no closed form
+   for the Bjorklund ordering, so it is read from phases.h, generated by
+   sim/phases, and the walk is then one addition and comparison per
+   step, with no division or recursion. Patterns of more than
+   EUCLIDEAN_PHASES_STEPS steps are computed by Bjorklund.
+
+   Has the interface of Bjorklund, as an Algorithm of Sequence.
+*/
+
+template<typename T>
+class Bresenham {
+public:
+  T compute(int8_t slots, int8_t pulses){
+    if(slots > EUCLIDEAN_PHASES_STEPS){
+      // enough levels for up to 128 slots, see bjorklund.h
+      Bjorklund<T, 12> algo;
+      return algo.compute(slots, pulses);
+    }
+    uint8_t n = slots, k = pulses;
+    uint8_t p = pgm_read_byte(&euclideanPhases[n * (n + 1) / 2 + k]);
+    T bits = 0;
+    T bit = 1;
+    for(uint8_t i=0; i<n; ++i){
+      if(p < k)
+	bits |= bit;
+      p += k;
+      if(p >= n)
+	p -= n;
+      bit <<= 1;
+    }
+    return bits;
+  }
+};
+
+#endif /* _BRESENHAM_H_ */
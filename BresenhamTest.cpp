@@ -0,0 +1,47 @@
+/*
+make build/sim/BresenhamTest && ./build/sim/BresenhamTest
+
+Tests that the Bresenham walk of Bresenham.h computes the patterns of
+the Bjorklund algorithm, alone and in a GateSequencer.
+*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Test
+#include <boost/test/unit_test.hpp>
+#include <stdio.h>
+#define SEQUENCER_BRESENHAM
+#include "golden.h"
+
+BOOST_AUTO_TEST_CASE(testEveryPattern){
+  for(int8_t n=1; n<=EUCLIDEAN_PHASES_STEPS; ++n){
+    for(int8_t k=0; k<=n; ++k){
+      Bjorklund<uint32_t, SEQUENCE_ALGORITHM_ARRAY_SIZE> algo;
+      Bresenham<uint32_t> walk;
+      BOOST_REQUIRE_MESSAGE(walk.compute(n, k) == algo.compute(n, k), "E(" << (int)k << "," << (int)n << ")");
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testLongerPatternsFallBack){
+  for(int8_t n=EUCLIDEAN_PHASES_STEPS+1; n<=64; ++n){
+    for(int8_t k=0; k<=n; ++k){
+      Bjorklund<uint64_t, SEQUENCE_ALGORITHM_ARRAY_SIZE> algo;
+      Bresenham<uint64_t> walk;
+      BOOST_REQUIRE_MESSAGE(walk.compute(n, k) == algo.compute(n, k), "E(" << (int)k << "," << (int)n << ")");
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testGoldenCorpus){
+  // the gates of every pattern, rotation and mode of a GateSequencer
+  // built with SEQUENCER_BRESENHAM, against those of the Bjorklund build
+  FILE* in = fopen("golden.bin", "rb");
+  BOOST_REQUIRE_MESSAGE(in, "cannot read golden.bin");
+  std::vector<uint8_t> golden;
+  uint8_t buf[4096];
+  size_t len;
+  while((len = fread(buf, 1, sizeof(buf), in)) > 0)
+    golden.insert(golden.end(), buf, buf+len);
+  fclose(in);
+  std::vector<uint8_t> corpus = goldenCorpus();
+  BOOST_CHECK(corpus == golden);
+}
@@ -0,0 +1,100 @@
+#ifndef _CHAINED_SEQUENCER_H_
+#define _CHAINED_SEQUENCER_H_
+
+#include "GateSequencer.h"
+
+/**
+   Plays a number of GateSequencers one after the other, each for a full
+   cycle of its own length, in a configurable order (eg A,B or A,A,B or B,A).
+   The output of the sequencer that is playing is mirrored to all channels.
+   The end of each segment is counted down from the sequencer length when
+   the segment starts, so that an edge costs the same regardless of the
+   number or length of segments.
+*/
+
+template<uint8_t CHANNELS, uint8_t SEGMENTS>
+class ChainedSequencer {
+public:
+  ChainedSequencer(GateSequencer** c, const uint8_t* order) : channels(c) {
+    setOrder(order);
+  }
+
+  /* order holds SEGMENTS channel indices */
+  void setOrder(const uint8_t* order){
+    for(uint8_t i=0; i<SEGMENTS; ++i)
+      segments[i] = channels[order[i]];
+    reset();
+  }
+
+  void rise(){
+    if(!remaining){
+      if(++index == SEGMENTS)
+	index = 0;
+      current = segments[index];
+      remaining = current->length;
+      SEQUENCER_TRACE_SEGMENT(index);
+    }
+    remaining--;
+    current->rise();
+    push();
+  }
+
+  void fall(){
+    current->fall();
+    push();
+  }
+
+  void reset(){
+    index = SEGMENTS-1;
+    current = segments[index];
+    remaining = 0;
+    SEQUENCER_TRACE_SEGMENT(index);
+  }
+
+  /* steps played in the cycle of all segments */
+  uint16_t getPosition(){
+    uint16_t step = 0;
+    for(uint8_t i=0; i<index; ++i)
+      step += segments[i]->length;
+    step += current->length - remaining;
+    return index == SEGMENTS-1 && !remaining ? 0 : step;
+  }
+
+  /* moves to a step of the cycle as if played from a reset */
+  void seek(uint16_t step){
+    for(uint8_t i=0; i<SEGMENTS; ++i)
+      segments[i]->seek(0);
+    reset();
+    if(!step)
+      return;
+    for(index=0; index<SEGMENTS-1 && step > segments[index]->length; ++index)
+      step -= segments[index]->length;
+    current = segments[index];
+    if(step > current->length){
+      reset();
+      return;
+    }
+    remaining = current->length - step;
+    current->seek(step);
+    SEQUENCER_TRACE_SEGMENT(index);
+  }
+
+  GateSequencer* getSegment(uint8_t i){
+    return segments[i];
+  }
+
+private:
+  void push(){
+    for(uint8_t i=0; i<CHANNELS; ++i)
+      if(channels[i] != current)
+	current->push(*channels[i]);
+  }
+
+  GateSequencer** channels;
+  GateSequencer* segments[SEGMENTS];
+  GateSequencer* volatile current;
+  volatile uint8_t index;
+  volatile uint8_t remaining;
+};
+
+#endif /* _CHAINED_SEQUENCER_H_ */
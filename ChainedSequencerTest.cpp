@@ -0,0 +1,113 @@
+/*
+make build/sim/ChainedSequencerTest && ./build/sim/ChainedSequencerTest
+
+Tests the segment order, segment lengths, mirrored gates and reset of
+ChainedSequencer.h.
+*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Test
+#include <boost/test/unit_test.hpp>
+#include <string>
+#include "render.h"
+
+/* resets the simulated ports before the sequencers configure them */
+struct Ports {
+  Ports(){
+    sim_reset();
+  }
+};
+
+/* A plays 3 steps all filled, B 5 steps with no fills, both triggering */
+struct Channels : Ports {
+  GateSequencer seqA;
+  GateSequencer seqB;
+  GateSequencer* channels[2];
+  Channels() :
+    seqA(SEQUENCER_OUTPUT_PIN_A, SEQUENCER_TRIGGER_SWITCH_PIN_A,
+	 SEQUENCER_ALTERNATE_SWITCH_PIN_A, SEQUENCER_LED_A_PIN),
+    seqB(SEQUENCER_OUTPUT_PIN_B, SEQUENCER_TRIGGER_SWITCH_PIN_B,
+	 SEQUENCER_ALTERNATE_SWITCH_PIN_B, SEQUENCER_LED_B_PIN) {
+    channels[0] = &seqA;
+    channels[1] = &seqB;
+    renderSetMode(seqA, SEQUENCER_TRIGGER_SWITCH_PIN_A, SEQUENCER_ALTERNATE_SWITCH_PIN_A,
+		  GateSequencer::TRIGGERING);
+    renderSetMode(seqB, SEQUENCER_TRIGGER_SWITCH_PIN_B, SEQUENCER_ALTERNATE_SWITCH_PIN_B,
+		  GateSequencer::TRIGGERING);
+    seqA.calculate(3, 3);
+    seqB.calculate(5, 0);
+    seqA.reset();
+    seqB.reset();
+  }
+};
+
+/* the channel that played each of a number of clock edges, checking
+   that both outputs carry its gate */
+template<uint8_t SEGMENTS>
+std::string play(Channels& c, ChainedSequencer<2, SEGMENTS>& chain, int edges){
+  std::string played;
+  for(int i=0; i<edges; ++i){
+    uint16_t a = c.seqA.getStep();
+    uint16_t b = c.seqB.getStep();
+    chain.rise();
+    bool isA = c.seqA.getStep() != a;
+    BOOST_REQUIRE(isA != (c.seqB.getStep() != b));
+    played += isA ? 'A' : 'B';
+    BOOST_CHECK_EQUAL(c.seqA.isOn(), isA);
+    BOOST_CHECK_EQUAL(c.seqB.isOn(), isA);
+    chain.fall();
+  }
+  return played;
+}
+
+BOOST_AUTO_TEST_CASE(testOrderAB){
+  Channels c;
+  const uint8_t order[] = { 0, 1 };
+  ChainedSequencer<2, 2> chain(c.channels, order);
+  BOOST_CHECK_EQUAL(play(c, chain, 16), "AAABBBBBAAABBBBB");
+  BOOST_CHECK_EQUAL(c.seqA.getStep(), 6);
+  BOOST_CHECK_EQUAL(c.seqB.getStep(), 10);
+}
+
+BOOST_AUTO_TEST_CASE(testOrderAAB){
+  Channels c;
+  const uint8_t order[] = { 0, 0, 1 };
+  ChainedSequencer<2, 3> chain(c.channels, order);
+  BOOST_CHECK_EQUAL(play(c, chain, 22), "AAAAAABBBBBAAAAAABBBBB");
+  BOOST_CHECK_EQUAL(c.seqA.getStep(), 12);
+  BOOST_CHECK_EQUAL(c.seqB.getStep(), 10);
+}
+
+BOOST_AUTO_TEST_CASE(testSegmentLengthsFollowSequencers){
+  Channels c;
+  const uint8_t order[] = { 1, 0 };
+  ChainedSequencer<2, 2> chain(c.channels, order);
+  BOOST_CHECK_EQUAL(play(c, chain, 8), "BBBBBAAA");
+  // a new length counts from the start of the next segment
+  c.seqA.calculate(2, 2);
+  c.seqB.calculate(4, 0);
+  BOOST_CHECK_EQUAL(play(c, chain, 12), "BBBBAABBBBAA");
+}
+
+BOOST_AUTO_TEST_CASE(testReset){
+  Channels c;
+  const uint8_t order[] = { 0, 0, 1 };
+  ChainedSequencer<2, 3> chain(c.channels, order);
+  for(int edges=0; edges<=11; ++edges){
+    play(c, chain, edges);
+    chain.reset();
+    BOOST_CHECK_EQUAL(chain.getPosition(), 0);
+    BOOST_CHECK_EQUAL(play(c, chain, 11), "AAAAAABBBBB");
+    BOOST_CHECK_EQUAL(chain.getPosition(), 0);
+    chain.reset();
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testPosition){
+  Channels c;
+  const uint8_t order[] = { 0, 0, 1 };
+  ChainedSequencer<2, 3> chain(c.channels, order);
+  for(int i=1; i<=33; ++i){
+    play(c, chain, 1);
+    BOOST_CHECK_EQUAL(chain.getPosition(), i % 11);
+  }
+}
@@ -0,0 +1,197 @@
+#ifndef _COMBINED_SEQUENCE_H_
+#define _COMBINED_SEQUENCE_H_
+
+#include <inttypes.h>
+#include "Sequence.h"
+
+/**
+   Logical combination of two sequences, eg A AND B or A XOR B.
+   The combined pattern repeats every lcm(A.length, B.length) steps and is
+   computed into a bit buffer whenever either sequence changes, so that
+   playing it back is a single bit lookup per step.
+   When both sequences have the same length the pattern is computed with
+   one bitwise operation on the (rotated) pattern words.
+   Periods longer than MAX_PERIOD are truncated.
+   The pattern is built in the buffer that next() is not playing, and
+   swapped in with interrupts masked, so that the clock interrupt plays
+   either the whole old pattern or the whole new one.
+
+   A new pattern is placed from the positions both sequences have
+   reached, which after a change of length need not be those of the
+   same step since the reset. The buffer then starts with B skewed by a
+   number of steps below gcd(A.length, B.length), which reset() cannot
+   place, so it asks for a new calculation instead. next() must be
+   called on every clock step that advances both sequences; while they
+   do not advance together, eg chained, invalidate() the pattern.
+*/
+
+template<typename T, uint16_t MAX_PERIOD>
+class CombinedSequence {
+public:
+  enum Operation {
+    AND                        =  0,
+    OR                         =  1,
+    XOR                        =  2,
+    AND_NOT                    =  3
+  };
+
+  CombinedSequence(Operation o) :
+    op(o), period(1), pos(0), counter(0), front(0), skew(0), resets(0),
+    stale(false), lengthA(0), lengthB(0) {}
+
+  /* recalculates the combined pattern if either sequence has changed */
+  template<class Algorithm>
+  void update(Sequence<T, Algorithm>& a, Sequence<T, Algorithm>& b){
+    if(!stale &&
+       a.bits == bitsA && a.length == lengthA && a.offset == offsetA &&
+       b.bits == bitsB && b.length == lengthB && b.offset == offsetB)
+      return;
+    stale = false;
+    bitsA = a.bits; lengthA = a.length; offsetA = a.offset;
+    bitsB = b.bits; lengthB = b.length; offsetB = b.offset;
+    calculate(a, b);
+  }
+
+  /* places the next update() from the positions of the sequences */
+  void invalidate(){
+    stale = true;
+  }
+
+  template<class Algorithm>
+  void calculate(Sequence<T, Algorithm>& a, Sequence<T, Algorithm>& b){
+    // the steps both sequences have reached, and the clock steps since
+    uint8_t phaseA, phaseB, reset;
+    uint32_t before;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+      phaseA = phase(a);
+      phaseB = phase(b);
+      before = counter;
+      reset = resets;
+    }
+    uint8_t g = gcd(a.length, b.length);
+    uint8_t d = (phaseB + g - phaseA % g) % g;
+    T* words = buffers[!front];
+    uint16_t p;
+    if(a.length == b.length){
+      p = a.length;
+      words[0] = combine(align(a, 0), align(b, d));
+    }else{
+      p = (uint16_t)(a.length / g) * b.length;
+      if(p > MAX_PERIOD)
+	p = MAX_PERIOD;
+      for(uint16_t i=0; i<WORDS; ++i)
+	words[i] = 0;
+      for(uint16_t i=0; i<p; ++i)
+	if(combine(a.peek(i), b.peek(d + i)) & 1)
+	  words[i / WORD_BITS] |= (T)1 << (i % WORD_BITS);
+    }
+    SEQUENCER_YIELD();
+    // the step of A and of B skewed by d, found with interrupts enabled
+    uint16_t step = phaseA;
+    while((step + d) % b.length != phaseB)
+      step += a.length;
+    SEQUENCER_YIELD();
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+      if(reset == resets){
+	front = !front;
+	period = p;
+	skew = d;
+	pos = (step + (uint16_t)(counter - before)) % p;
+      }else if(!d){
+	// reset since, to step 0 of both
+	front = !front;
+	period = p;
+	skew = 0;
+	pos = counter % p;
+      }else{
+	stale = true;
+      }
+    }
+  }
+
+  void reset(){
+    pos = 0;
+    counter = 0;
+    resets++;
+    if(skew)
+      stale = true;
+  }
+
+  bool next(){
+    bool bit = (buffers[front][pos / WORD_BITS] >> (pos % WORD_BITS)) & 1;
+    if(++pos == period)
+      pos = 0;
+    counter++;
+    return bit;
+  }
+
+  /* value at a step of the combined cycle */
+  bool peek(uint16_t step) const {
+    return (buffers[front][step / WORD_BITS] >> (step % WORD_BITS)) & 1;
+  }
+
+  uint16_t getPosition() const {
+    return pos;
+  }
+
+  Operation op;
+  uint16_t period;
+
+private:
+  static const uint8_t WORD_BITS = sizeof(T)*8;
+  static const uint16_t WORDS = (MAX_PERIOD + WORD_BITS - 1) / WORD_BITS;
+
+  T combine(T a, T b){
+    switch(op){
+    case AND:
+      return a & b;
+    case OR:
+      return a | b;
+    case XOR:
+      return a ^ b;
+    case AND_NOT:
+      return a & ~b;
+    }
+    return 0;
+  }
+
+  /* pattern word rotated so that bit 0 is step d after a reset */
+  template<class Algorithm>
+  static T align(Sequence<T, Algorithm>& seq, uint8_t d){
+    uint8_t shift = (seq.length + seq.offset % seq.length + d) % seq.length;
+    T bits = seq.bits;
+    if(shift)
+      bits = (bits >> shift) | (bits << (seq.length - shift));
+    if(seq.length < WORD_BITS)
+      bits &= ((T)1 << seq.length) - 1;
+    return bits;
+  }
+
+  /* the step of a sequence since its last full cycle */
+  template<class Algorithm>
+  static inline uint8_t phase(Sequence<T, Algorithm>& seq){
+    return (seq.length + seq.pos - seq.offset % seq.length) % seq.length;
+  }
+
+  static uint8_t gcd(uint8_t x, uint8_t y){
+    while(y){
+      uint8_t t = x % y;
+      x = y;
+      y = t;
+    }
+    return x;
+  }
+
+  T buffers[2][WORDS];
+  volatile uint16_t pos;
+  volatile uint32_t counter;
+  volatile uint8_t front;
+  volatile uint8_t skew;
+  volatile uint8_t resets;
+  volatile bool stale;
+  T bitsA, bitsB;
+  uint8_t lengthA, lengthB;
+  int8_t offsetA, offsetB;
+};
+
+#endif /* _COMBINED_SEQUENCE_H_ */
@@ -0,0 +1,140 @@
+/*
+make build/sim/CombinedSequenceTest && ./build/sim/CombinedSequenceTest
+
+Tests the logical combinations of CombinedSequence.h against stepping
+both sequences.
+*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Test
+#include <boost/test/unit_test.hpp>
+#include "CombinedSequence.h"
+
+typedef Sequence<uint32_t> Sequence32;
+typedef CombinedSequence<uint32_t, 32*31> Combined32;
+
+void testCombination(Combined32::Operation op, int lenA, int lenB){
+  Sequence32 a, b;
+  a.calculate(lenA, lenA/2);
+  b.calculate(lenB, lenB/3+1);
+  a.rotate(lenA/3);
+  b.rotate(1);
+  a.reset();
+  b.reset();
+  Combined32 logic(op);
+  logic.calculate(a, b);
+  for(int i=0; i<lenA*lenB*2; ++i){
+    bool x = a.next();
+    bool y = b.next();
+    bool expect;
+    switch(op){
+    case Combined32::AND:
+      expect = x && y;
+      break;
+    case Combined32::OR:
+      expect = x || y;
+      break;
+    case Combined32::XOR:
+      expect = x != y;
+      break;
+    case Combined32::AND_NOT:
+      expect = x && !y;
+      break;
+    }
+    BOOST_CHECK_EQUAL(logic.next(), expect);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testCombinedSameLength){
+  for(int len=2; len<=32; ++len){
+    testCombination(Combined32::AND, len, len);
+    testCombination(Combined32::XOR, len, len);
+    testCombination(Combined32::AND_NOT, len, len);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testCombinedPolymetric){
+  testCombination(Combined32::OR, 7, 12);
+  testCombination(Combined32::XOR, 16, 15);
+  testCombination(Combined32::AND, 3, 32);
+  BOOST_CHECK_EQUAL(Combined32(Combined32::AND).period, 1);
+}
+
+BOOST_AUTO_TEST_CASE(testCombinedKeepsStepOnRecalculation){
+  Sequence32 a, b;
+  a.calculate(7, 3);
+  b.calculate(12, 5);
+  Combined32 logic(Combined32::XOR);
+  logic.calculate(a, b);
+  // the clock plays 30 steps, then the pattern of B changes
+  for(int i=0; i<30; ++i){
+    a.next();
+    b.next();
+    logic.next();
+  }
+  b.calculate(12, 7);
+  logic.update(a, b);
+  BOOST_CHECK_EQUAL(logic.getPosition(), 30);
+  for(int i=0; i<200; ++i)
+    BOOST_CHECK_EQUAL(logic.next(), a.next() != b.next());
+  logic.reset();
+  a.reset();
+  b.reset();
+  b.calculate(9, 4);
+  logic.update(a, b);
+  BOOST_CHECK_EQUAL(logic.getPosition(), 0);
+  for(int i=0; i<100; ++i)
+    BOOST_CHECK_EQUAL(logic.next(), a.next() != b.next());
+}
+
+BOOST_AUTO_TEST_CASE(testCombinedFollowsLengthChange){
+  Sequence32 a, b;
+  a.calculate(5, 2);
+  b.calculate(4, 1);
+  b.rotate(1);
+  Combined32 logic(Combined32::XOR);
+  logic.update(a, b);
+  // the step knob of A turns at step 7, A keeps its position
+  for(int i=0; i<7; ++i)
+    BOOST_CHECK_EQUAL(logic.next(), a.next() != b.next());
+  a.calculate(7, 3);
+  logic.update(a, b);
+  for(int i=0; i<200; ++i)
+    BOOST_CHECK_EQUAL(logic.next(), a.next() != b.next());
+  // and again with lengths of a common divisor, so B is skewed
+  b.calculate(14, 5);
+  logic.update(a, b);
+  for(int i=0; i<3; ++i)
+    BOOST_CHECK_EQUAL(logic.next(), a.next() != b.next());
+  a.calculate(4, 3);
+  logic.update(a, b);
+  for(int i=0; i<200; ++i)
+    BOOST_CHECK_EQUAL(logic.next(), a.next() != b.next());
+  // a reset cannot place the skewed pattern, the next update does
+  a.reset();
+  b.reset();
+  logic.reset();
+  logic.update(a, b);
+  BOOST_CHECK_EQUAL(logic.getPosition(), 0);
+  for(int i=0; i<200; ++i)
+    BOOST_CHECK_EQUAL(logic.next(), a.next() != b.next());
+}
+
+BOOST_AUTO_TEST_CASE(testCombinedInvalidated){
+  Sequence32 a, b;
+  a.calculate(6, 2);
+  b.calculate(9, 4);
+  Combined32 logic(Combined32::AND);
+  logic.update(a, b);
+  // the sequences take turns, as when chained
+  for(int i=0; i<6; ++i)
+    a.next();
+  for(int i=0; i<4; ++i)
+    b.next();
+  logic.invalidate();
+  logic.update(a, b);
+  for(int i=0; i<100; ++i){
+    bool x = a.next();
+    bool y = b.next();
+    BOOST_CHECK_EQUAL(logic.next(), x && y);
+  }
+}
@@ -0,0 +1,269 @@
+#ifndef _CYCLE_CACHE_H_
+#define _CYCLE_CACHE_H_
+
+#include <inttypes.h>
+#include <util/atomic.h>
+#include "GateSequencer.h"
+#include "ChainedSequencer.h"
+
+#ifdef SEQUENCER_TRACE
+/* the position in the pattern of a sequencer at step i of its cycle */
+#define CYCLE_CACHE_STEP(seq, i) \
+  (((i) + (seq).offset % (seq).length + (seq).length) % (seq).length)
+#else
+#define CYCLE_CACHE_STEP(seq, i) 0
+#endif
+
+/**
+   Plays both channels from their whole combined cycle, precomputed
+   whenever a pattern, length or rotation changes: lcm(A, B) steps when
+   the channels run side by side, and the sum of the segment lengths
+   when they are chained. The cycle is kept as one bit per step and
+   channel in packed bytes, so a clock edge reads a bit per channel and
+   plays it in the gate mode of its channel, with no pattern stepping.
+
+   The memory budget is MAX_PERIOD steps, MAX_PERIOD / 4 bytes for both
+   channels. Longer cycles, and the clock edges while update() computes
+   a new cycle or of a mode the cycle was not computed for, fall back to
+   stepping the sequencers live, which are first moved to the step the
+   cache had reached. The cache takes over again on the next update()
+   from the live positions, if they are those of a step of the cycle: a
+   switch of the chained mode leaves them out of step until a reset.
+
+   A new rotation or pattern plays from the next update() on, rather
+   than from the next clock edge, and after a change of length both
+   channels continue from the step of the cycle the cache had reached.
+   update() runs in the main loop, rise() and fall() in the clock
+   interrupt. With SEQUENCER_COMBINE_OPERATION the positions of both
+   channels still move on with each cached step, for CombinedSequence.
+*/
+
+template<uint16_t MAX_PERIOD, uint8_t SEGMENTS>
+class CycleCache {
+public:
+  CycleCache(GateSequencer& seqA, GateSequencer& seqB, ChainedSequencer<2, SEGMENTS>& c) :
+    a(seqA), b(seqB), chain(c), period(0), pos(0), segment(SEGMENTS-1),
+    chained(false), valid(false), live(true), lengthA(0), lengthB(0) {}
+
+  /* recalculates the cycle of a mode if it or the sequences have changed */
+  void update(bool chainedMode){
+    if(chainedMode != chained || !valid ||
+       a.bits != bitsA || a.length != lengthA || a.offset != offsetA ||
+       b.bits != bitsB || b.length != lengthB || b.offset != offsetB){
+      ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+	if(!live)
+	  goLive();
+	valid = false;
+      }
+      chained = chainedMode;
+      bitsA = a.bits; lengthA = a.length; offsetA = a.offset;
+      bitsB = b.bits; lengthB = b.length; offsetB = b.offset;
+      if(!calculate())
+	return;
+      valid = true;
+    }
+    if(live){
+      ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+	uint16_t p;
+	if(livePosition(p)){
+	  pos = p;
+	  segment = locate(p);
+	  live = false;
+	}
+      }
+    }
+  }
+
+  void rise(bool chainedMode){
+    if(!playing(chainedMode)){
+      if(!live)
+	goLive();
+      if(chainedMode){
+	chain.rise();
+      }else{
+	a.rise();
+	b.rise();
+      }
+      return;
+    }
+    if(chained){
+      if(!pos)
+	segment = 0;
+      else if(pos == ends[segment])
+	segment++;
+      GateSequencer* current = chain.getSegment(segment);
+      current->play(bit(0, pos), CYCLE_CACHE_STEP(*current, pos - (segment ? ends[segment-1] : 0)));
+      push(current);
+    }else{
+      a.play(bit(0, pos), CYCLE_CACHE_STEP(a, pos));
+      b.play(bit(1, pos), CYCLE_CACHE_STEP(b, pos));
+#ifdef SEQUENCER_COMBINE_OPERATION
+      // CombinedSequence places its pattern from their positions
+      a.skip();
+      b.skip();
+#endif
+    }
+    if(++pos == period)
+      pos = 0;
+  }
+
+  void fall(bool chainedMode){
+    if(!playing(chainedMode)){
+      if(!live)
+	goLive();
+      if(chainedMode){
+	chain.fall();
+	return;
+      }
+    }else if(chained){
+      GateSequencer* current = chain.getSegment(segment);
+      current->fall();
+      push(current);
+      return;
+    }
+    a.fall();
+    b.fall();
+  }
+
+  /* as after resetting the sequencers and the chain */
+  void reset(){
+    pos = 0;
+    segment = SEGMENTS-1;
+  }
+
+  /* true while the clock plays from the cache */
+  bool isCached(){
+    return valid && !live;
+  }
+
+  /* steps in the cycle of the mode last updated */
+  uint16_t getPeriod(){
+    return period;
+  }
+
+private:
+  inline bool playing(bool chainedMode){
+    return valid && !live && chainedMode == chained;
+  }
+
+  inline bool bit(uint8_t lane, uint16_t i){
+    return (lanes[lane][i >> 3] >> (i & 7)) & 1;
+  }
+
+  /* the output of the channel playing to the other one, as the chain does */
+  inline void push(GateSequencer* current){
+    current->push(current == &a ? b : a);
+  }
+
+  /* false if the cycle is longer than the budget */
+  bool calculate(){
+    uint16_t p = 0;
+    if(chained){
+      for(uint8_t i=0; i<SEGMENTS; ++i){
+	p += chain.getSegment(i)->length;
+	ends[i] = p;
+      }
+    }else{
+      p = lcm(a.length, b.length);
+    }
+    period = p;
+    if(p > MAX_PERIOD)
+      return false;
+    for(uint16_t i=0; i<BYTES; ++i)
+      lanes[0][i] = lanes[1][i] = 0;
+    if(chained){
+      uint16_t i = 0;
+      for(uint8_t s=0; s<SEGMENTS; ++s){
+	GateSequencer* seq = chain.getSegment(s);
+	for(uint8_t k=0; k<seq->length; ++k, ++i)
+	  if(seq->peek(k))
+	    lanes[0][i >> 3] |= 1 << (i & 7);
+      }
+    }else{
+      for(uint16_t i=0; i<p; ++i){
+	if(a.peek(i))
+	  lanes[0][i >> 3] |= 1 << (i & 7);
+	if(b.peek(i))
+	  lanes[1][i >> 3] |= 1 << (i & 7);
+      }
+    }
+    return true;
+  }
+
+  /* moves the sequencers to the step the cache has reached */
+  void goLive(){
+    if(chained){
+      chain.seek(pos);
+    }else{
+      a.seek(pos);
+      b.seek(pos);
+    }
+    live = true;
+  }
+
+  /* the step of the cycle the live sequencers have reached, false if
+     their positions are not those of any step */
+  bool livePosition(uint16_t& p){
+    if(chained){
+      // a length changed in the middle of a segment leaves the chain past it
+      p = chain.getPosition();
+      if(p >= period)
+	return false;
+      uint8_t s = locate(p);
+      GateSequencer* current = chain.getSegment(s);
+      uint8_t played = p ? p - (s ? ends[s-1] : 0) : 0;
+      return local(a) == (current == &a ? played % a.length : 0) &&
+	local(b) == (current == &b ? played % b.length : 0);
+    }
+    // the step below the lcm with the positions of both
+    uint8_t stepB = local(b);
+    for(p = local(a); p < period; p += a.length)
+      if(p % b.length == stepB)
+	return true;
+    return false;
+  }
+
+  /* the step of a sequence since its last full cycle */
+  static inline uint8_t local(GateSequencer& seq){
+    return (seq.length + seq.pos - seq.offset % seq.length) % seq.length;
+  }
+
+  /* the segment that played step i - 1 */
+  uint8_t locate(uint16_t i){
+    if(!chained || !i)
+      return SEGMENTS-1;
+    uint8_t s = 0;
+    while(s < SEGMENTS-1 && i > ends[s])
+      s++;
+    return s;
+  }
+
+  static uint16_t lcm(uint8_t x, uint8_t y){
+    uint8_t p = x, q = y;
+    while(q){
+      uint8_t t = p % q;
+      p = q;
+      q = t;
+    }
+    return (uint16_t)(x / p) * y;
+  }
+
+  static const uint16_t BYTES = (MAX_PERIOD + 7) / 8;
+
+  GateSequencer& a;
+  GateSequencer& b;
+  ChainedSequencer<2, SEGMENTS>& chain;
+  uint8_t lanes[2][BYTES];
+  uint16_t ends[SEGMENTS];
+  uint16_t period;
+  volatile uint16_t pos;
+  volatile uint8_t segment;
+  volatile bool chained;
+  volatile bool valid;
+  volatile bool live;
+  SEQUENCER_BITS_TYPE bitsA, bitsB;
+  uint8_t lengthA, lengthB;
+  int8_t offsetA, offsetB;
+};
+
+#endif /* _CYCLE_CACHE_H_ */
@@ -0,0 +1,130 @@
+/*
+make build/sim/CycleCacheTest && ./build/sim/CycleCacheTest
+
+Tests that playing from the cycle cache of CycleCache.h gives the gates
+of stepping the sequencers live, with and without a fallback.
+*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Test
+#include <boost/test/unit_test.hpp>
+#include <stdlib.h>
+#include <vector>
+#include "render.h"
+#include "CycleCache.h"
+
+/* the gates after each clock edge of a random script, played live or
+   from a cache with a budget of MAX_PERIOD steps */
+template<uint16_t MAX_PERIOD, uint8_t SEGMENTS>
+std::vector<uint8_t> play(bool cached, unsigned seed, const uint8_t* order, uint32_t* hits = NULL){
+  srand(seed);
+  sim_reset();
+  GateSequencer seqA(SEQUENCER_OUTPUT_PIN_A, SEQUENCER_TRIGGER_SWITCH_PIN_A,
+		     SEQUENCER_ALTERNATE_SWITCH_PIN_A, SEQUENCER_LED_A_PIN);
+  GateSequencer seqB(SEQUENCER_OUTPUT_PIN_B, SEQUENCER_TRIGGER_SWITCH_PIN_B,
+		     SEQUENCER_ALTERNATE_SWITCH_PIN_B, SEQUENCER_LED_B_PIN);
+  GateSequencer* channels[] = { &seqA, &seqB };
+  ChainedSequencer<2, SEGMENTS> combined(channels, order);
+  CycleCache<MAX_PERIOD, SEGMENTS> cycle(seqA, seqB, combined);
+  const uint8_t trigger[] = { SEQUENCER_TRIGGER_SWITCH_PIN_A, SEQUENCER_TRIGGER_SWITCH_PIN_B };
+  const uint8_t alternate[] = { SEQUENCER_ALTERNATE_SWITCH_PIN_A, SEQUENCER_ALTERNATE_SWITCH_PIN_B };
+  for(uint8_t c=0; c<2; ++c){
+    uint8_t steps = 1 + rand() % SEQUENCER_STEPS_RANGE;
+    channels[c]->calculate(steps, rand() % (steps + 1));
+    renderSetMode(*channels[c], trigger[c], alternate[c],
+		  (GateSequencer::GateSequencerMode)(1 + rand() % 2));
+  }
+  bool chained = rand() & 1;
+  std::vector<uint8_t> gates;
+  for(uint32_t i=0; i<20000; ++i){
+    // changes between any two edges, as the main loop and the reset interrupt make them
+    {
+      uint8_t c = rand() & 1;
+      switch(rand() % 128){
+      case 0:
+	channels[c]->rotate(rand() % 16);
+	break;
+      case 1:
+	channels[c]->calculate(channels[c]->length, rand() % (channels[c]->length + 1));
+	break;
+      case 2:
+	renderSetMode(*channels[c], trigger[c], alternate[c], (GateSequencer::GateSequencerMode)(rand() % 3));
+	break;
+      case 3:
+	if(rand() % 4 == 0)
+	  chained = !chained;
+	break;
+      case 4:
+	seqA.reset();
+	seqB.reset();
+	combined.reset();
+	cycle.reset();
+	break;
+      }
+    }
+    if(cached){
+      cycle.update(chained);
+      if(hits)
+	*hits += cycle.isCached();
+      (i & 1) ? cycle.fall(chained) : cycle.rise(chained);
+    }else if(chained){
+      (i & 1) ? combined.fall() : combined.rise();
+    }else if(i & 1){
+      seqA.fall();
+      seqB.fall();
+    }else{
+      seqA.rise();
+      seqB.rise();
+    }
+    gates.push_back(seqA.isOn() | seqB.isOn() << 1);
+  }
+  return gates;
+}
+
+BOOST_AUTO_TEST_CASE(testCachedMatchesLive){
+  const uint8_t order[] = { 0, 1 };
+  uint32_t hits = 0;
+  for(unsigned seed=1; seed<=200; ++seed){
+    std::vector<uint8_t> live = play<SEQUENCER_COMBINED_PERIOD, 2>(false, seed, order);
+    std::vector<uint8_t> cached = play<SEQUENCER_COMBINED_PERIOD, 2>(true, seed, order, &hits);
+    BOOST_REQUIRE_MESSAGE(live == cached, "seed " << seed);
+  }
+  // most edges play from the cache
+  BOOST_CHECK_GT(hits, 200 * 20000 / 2);
+}
+
+BOOST_AUTO_TEST_CASE(testFallbackMatchesLive){
+  // a budget of 24 steps caches chained cycles and a few lcms only
+  const uint8_t order[] = { 0, 0, 1 };
+  uint32_t hits = 0;
+  for(unsigned seed=1; seed<=200; ++seed){
+    std::vector<uint8_t> live = play<24, 3>(false, seed, order);
+    std::vector<uint8_t> cached = play<24, 3>(true, seed, order, &hits);
+    BOOST_REQUIRE_MESSAGE(live == cached, "seed " << seed);
+  }
+  BOOST_CHECK_GT(hits, 0);
+  BOOST_CHECK_LT(hits, 200 * 20000);
+}
+
+BOOST_AUTO_TEST_CASE(testPeriods){
+  sim_reset();
+  GateSequencer seqA(SEQUENCER_OUTPUT_PIN_A, SEQUENCER_TRIGGER_SWITCH_PIN_A,
+		     SEQUENCER_ALTERNATE_SWITCH_PIN_A, SEQUENCER_LED_A_PIN);
+  GateSequencer seqB(SEQUENCER_OUTPUT_PIN_B, SEQUENCER_TRIGGER_SWITCH_PIN_B,
+		     SEQUENCER_ALTERNATE_SWITCH_PIN_B, SEQUENCER_LED_B_PIN);
+  GateSequencer* channels[] = { &seqA, &seqB };
+  const uint8_t order[] = { 0, 1 };
+  ChainedSequencer<2, 2> combined(channels, order);
+  CycleCache<64, 2> cycle(seqA, seqB, combined);
+  seqA.calculate(7, 3);
+  seqB.calculate(12, 5);
+  cycle.update(false);
+  BOOST_CHECK_EQUAL(cycle.getPeriod(), 84);
+  BOOST_CHECK(!cycle.isCached());
+  cycle.update(true);
+  BOOST_CHECK_EQUAL(cycle.getPeriod(), 19);
+  BOOST_CHECK(cycle.isCached());
+  seqB.calculate(14, 5);
+  cycle.update(false);
+  BOOST_CHECK_EQUAL(cycle.getPeriod(), 14);
+  BOOST_CHECK(cycle.isCached());
+}
@@ -0,0 +1,153 @@
+#ifndef _DIAGNOSTICS_H_
+#define _DIAGNOSTICS_H_
+
+/**
+   Runtime diagnostics of an instrumented build (SEQUENCER_DIAGNOSTICS):
+   the stack high-water mark, and for each interrupt handler the number
+   of entries and of overlaps, ie times its interrupt was requested while
+   a handler was running, so that it was delayed or merged with the next
+   one.
+
+   Free SRAM between the end of the static data and the stack is painted
+   before the C runtime starts, and the high-water mark is found by
+   scanning for the first overwritten byte when the diagnostics are
+   printed, so it costs nothing at run time. The handlers only increment
+   counters. The host simulation has no SRAM to paint and reports no
+   stack figures.
+
+   Every byte received on the serial port prints the diagnostics, and
+   'c' also clears the counters.
+*/
+
+#define DIAGNOSTICS_INT0         0
+#define DIAGNOSTICS_INT1         1
+#define DIAGNOSTICS_ADC          2
+#define DIAGNOSTICS_EE_READY     3
+#define DIAGNOSTICS_TIMER1_OVF   4
+#define DIAGNOSTICS_VECTORS      5
+
+#ifdef SEQUENCER_DIAGNOSTICS
+
+#ifdef SEQUENCER_INPUT_LOG
+#error The input log and the diagnostics both use the serial port!
+#endif
+
+#include <inttypes.h>
+#include <avr/io.h>
+#include <util/atomic.h>
+#include "serial.h"
+
+#define DIAGNOSTICS_PAINT        0xc5
+
+/* called as a handler returns, so that it sees the interrupts that
+   became pending while it ran */
+#define DIAGNOSTICS_EXIT(vector)  diagnostics.exit(vector)
+
+#ifdef __AVR__
+extern uint8_t _end;
+extern uint8_t __stack;
+
+/* runs before the stack pointer is set up, so no C */
+void diagnosticsPaint() __attribute__((naked, used, section(".init1")));
+void diagnosticsPaint(){
+  __asm volatile("    ldi r30, lo8(_end)\n"
+		 "    ldi r31, hi8(_end)\n"
+		 "    ldi r24, %0\n"
+		 "    ldi r25, hi8(__stack)\n"
+		 "    rjmp 2f\n"
+		 "1:  st Z+, r24\n"
+		 "2:  cpi r30, lo8(__stack)\n"
+		 "    cpc r31, r25\n"
+		 "    brlo 1b\n"
+		 "    breq 1b\n"
+		 :: "M" (DIAGNOSTICS_PAINT));
+}
+#endif /* __AVR__ */
+
+class Diagnostics {
+public:
+  Diagnostics(){
+    clear();
+  }
+
+  /* counts the interrupts that became pending while this handler ran */
+  inline void exit(uint8_t vector){
+    entries[vector]++;
+    if(EIFR & _BV(INTF0))
+      overlaps[DIAGNOSTICS_INT0]++;
+    if(EIFR & _BV(INTF1))
+      overlaps[DIAGNOSTICS_INT1]++;
+    if(ADCSRA & _BV(ADIF))
+      overlaps[DIAGNOSTICS_ADC]++;
+  }
+
+  void clear(){
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+      for(uint8_t i=0; i<DIAGNOSTICS_VECTORS; ++i){
+	entries[i] = 0;
+	overlaps[i] = 0;
+      }
+    }
+  }
+
+  /* bytes of SRAM the stack has never reached */
+  uint16_t stackUnused(){
+#ifdef __AVR__
+    const uint8_t* p = &_end;
+    while(p <= &__stack && *p == DIAGNOSTICS_PAINT)
+      p++;
+    return p - &_end;
+#else
+    return 0;
+#endif
+  }
+
+  uint16_t stackSize(){
+#ifdef __AVR__
+    return &__stack - &_end + 1;
+#else
+    return 0;
+#endif
+  }
+
+  void print(){
+    uint32_t e[DIAGNOSTICS_VECTORS];
+    uint16_t o[DIAGNOSTICS_VECTORS];
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+      for(uint8_t i=0; i<DIAGNOSTICS_VECTORS; ++i){
+	e[i] = entries[i];
+	o[i] = overlaps[i];
+      }
+    }
+    static const char* const names[DIAGNOSTICS_VECTORS] = {
+      "int0", "int1", "adc", "ee", "t1ovf"
+    };
+    printString("stack ");
+    printInteger(stackSize() - stackUnused());
+    printByte('/');
+    printInteger(stackSize());
+    for(uint8_t i=0; i<DIAGNOSTICS_VECTORS; ++i){
+      printByte(' ');
+      printString(names[i]);
+      printByte(' ');
+      printInteger(e[i]);
+      printByte('/');
+      printInteger(o[i]);
+    }
+    printNewline();
+  }
+
+private:
+  volatile uint32_t entries[DIAGNOSTICS_VECTORS];
+  volatile uint16_t overlaps[DIAGNOSTICS_VECTORS];
+};
+
+extern Diagnostics diagnostics;
+
+#else
+
+#define DIAGNOSTICS_EXIT(vector)
+
+#endif /* SEQUENCER_DIAGNOSTICS */
+
+#endif /* _DIAGNOSTICS_H_ */
@@ -0,0 +1,73 @@
+/*
+make generatorbench BENCHARGS="-j generator.json"
+
+Benchmarks generating every Euclidean pattern of up to 32 steps with
+Bjorklund and with each kernel of the closed form generator, and prints
+the patterns generated per second on one core.
+usage: EuclideanGeneratorBenchmark [-j file.json] [name filter]
+*/
+
+#include <stdlib.h>
+#include "benchmark.h"
+#include "Sequence.h"
+#include "lib/EuclideanGenerator.h"
+
+typedef Bjorklund<uint32_t, SEQUENCE_ALGORITHM_ARRAY_SIZE> Bjorklund32;
+
+static const char* kernelNames[] = { "auto", "scalar", "sse2", "avx2" };
+
+int main(int argc, char** argv){
+  const char* json = NULL;
+  std::string filter;
+  for(int i=1; i<argc; ++i){
+    if(!strcmp(argv[i], "-j") && i+1 < argc)
+      json = argv[++i];
+    else
+      filter = argv[i];
+  }
+  Benchmark bench;
+#define BENCHMARK(title, body) \
+  if(std::string(title).find(filter) != std::string::npos) \
+    bench.run(title, [&](uint64_t n){ for(uint64_t i=0; i<n; ++i){ body; } })
+
+  std::vector<uint8_t> steps, fills;
+  for(uint8_t n=1; n<=EUCLIDEAN_GENERATOR_MAX_STEPS; ++n){
+    for(uint8_t k=0; k<=n; ++k){
+      steps.push_back(n);
+      fills.push_back(k);
+    }
+  }
+  size_t count = steps.size();
+  std::vector<uint32_t> bits(count);
+
+  BENCHMARK("bjorklund/compute",
+	    for(size_t j=0; j<count; ++j){
+	      Bjorklund32 algo;
+	      bits[j] = algo.compute(steps[j], fills[j]);
+	    }
+	    benchmarkKeep(bits[i % count]));
+  for(int k=EuclideanGenerator::SCALAR; k<=EuclideanGenerator::AVX2; ++k){
+    if(!EuclideanGenerator::supported((EuclideanGenerator::Kernel)k))
+      continue;
+    EuclideanGenerator generator((EuclideanGenerator::Kernel)k);
+    BENCHMARK(std::string("closedform/") + kernelNames[k],
+	      generator.generate(&steps[0], &fills[0], &bits[0], count);
+	      benchmarkKeep(bits[i % count]));
+  }
+
+  printf("\n%-40s %16s\n", "", "patterns/s");
+  const std::vector<BenchmarkResult>& results = bench.getResults();
+  for(size_t i=0; i<results.size(); ++i)
+    printf("%-40s %16.0f\n", results[i].name.c_str(), count * 1e9 / results[i].median);
+
+  if(json){
+    FILE* out = fopen(json, "w");
+    if(!out){
+      perror(json);
+      return 1;
+    }
+    bench.writeJson(out);
+    fclose(out);
+  }
+  return 0;
+}
@@ -0,0 +1,61 @@
+/*
+make build/sim/EuclideanGeneratorTest && ./build/sim/EuclideanGeneratorTest
+
+Tests the closed form generators, and the Bresenham walk as a Sequence
+algorithm, against Bjorklund.
+*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Test
+#include <boost/test/unit_test.hpp>
+#include <vector>
+#include "Sequence.h"
+#include "lib/EuclideanGenerator.h"
+
+static const EuclideanGenerator::Kernel kernels[] = {
+  EuclideanGenerator::SCALAR, EuclideanGenerator::SSE2, EuclideanGenerator::AVX2
+};
+
+uint32_t bjorklund(uint8_t steps, uint8_t fills){
+  Bjorklund<uint32_t, SEQUENCE_ALGORITHM_ARRAY_SIZE> algo;
+  return algo.compute(steps, fills);
+}
+
+BOOST_AUTO_TEST_CASE(testKernelsMatchBjorklund){
+  std::vector<uint8_t> steps, fills;
+  for(uint8_t n=1; n<=EUCLIDEAN_GENERATOR_MAX_STEPS; ++n){
+    for(uint8_t k=0; k<=n; ++k){
+      steps.push_back(n);
+      fills.push_back(k);
+    }
+  }
+  for(EuclideanGenerator::Kernel kernel : kernels){
+    if(!EuclideanGenerator::supported(kernel))
+      continue;
+    EuclideanGenerator generator(kernel);
+    BOOST_REQUIRE_EQUAL(generator.getKernel(), kernel);
+    // every offset, so that each pattern goes through the vector lanes and the tail
+    for(size_t start=0; start<8; ++start){
+      std::vector<uint32_t> bits(steps.size() - start);
+      generator.generate(&steps[start], &fills[start], &bits[0], bits.size());
+      for(size_t j=0; j<bits.size(); ++j)
+	BOOST_REQUIRE_MESSAGE(bits[j] == bjorklund(steps[start+j], fills[start+j]),
+			      "kernel " << kernel << " E(" << (int)fills[start+j] << ", " <<
+			      (int)steps[start+j] << ")");
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testSequencePolicy){
+  Sequence<uint32_t> a;
+  Sequence<uint32_t, Bresenham<uint32_t> > b;
+  for(uint8_t n=1; n<=EUCLIDEAN_GENERATOR_MAX_STEPS; ++n){
+    for(uint8_t k=0; k<=n; ++k){
+      a.calculate(n, k);
+      b.calculate(n, k);
+      a.rotate(k % n);
+      b.rotate(k % n);
+      for(int i=0; i<2*n; ++i)
+	BOOST_REQUIRE_EQUAL(a.next(), b.next());
+    }
+  }
+}
@@ -6,11 +6,36 @@
 #include "device.h"
 #include "adc_freerunner.cpp"
 #include "GateSequencer.h"
+#include "ChainedSequencer.h"
+#include "CombinedSequence.h"
+#ifdef SEQUENCER_CYCLE_CACHE
+#include "CycleCache.h"
+#endif /* SEQUENCER_CYCLE_CACHE */
+#include "PresetStore.h"
+#include <string.h>
+#ifdef SEQUENCER_INPUT_LOG
+#include "InputLog.h"
+#endif /* SEQUENCER_INPUT_LOG */
 
 #ifdef SERIAL_DEBUG
 #include "serial.h"
 #endif // SERIAL_DEBUG
 
+#ifdef SEQUENCER_DIAGNOSTICS
+Diagnostics diagnostics;
+#endif
+#ifdef SEQUENCER_PROFILE
+Profiler profiler;
+#endif
+#ifdef SEQUENCER_LATENCY
+LatencyMeter latency;
+
+ISR(TIMER1_OVF_vect){
+  latency.overflow();
+  DIAGNOSTICS_EXIT(DIAGNOSTICS_TIMER1_OVF);
+}
+#endif
+
 inline bool clockIsHigh(){
   return !(SEQUENCER_CLOCK_PINS & _BV(SEQUENCER_CLOCK_PIN));
 }
@@ -34,47 +59,105 @@ GateSequencer seqB(SEQUENCER_OUTPUT_PIN_B,
 		   SEQUENCER_LED_B_PIN);
 
 
-class MetaSequencer {
-public:
-  uint8_t counter;
-  void rise(){
-    if(++counter >= seqA.length+seqB.length)
-      counter = 0;
-    if(counter < seqA.length){
-      seqA.rise();
-      seqA.push(seqB);
-    }else{
-      seqB.rise();
-      seqB.push(seqA);
-    }
-  }
-  void fall(){
-    if(counter < seqA.length){
-      seqA.fall();
-      seqA.push(seqB);
-    }else{
-      seqB.fall();
-      seqB.push(seqA);
-    }
-  }
-  void reset(){
-    counter = 0;
-  }
-};
+GateSequencer* channels[] = { &seqA, &seqB };
+const uint8_t chainOrder[] = { 0, 1 }; // A then B
+
+ChainedSequencer<2, sizeof(chainOrder)> combined(channels, chainOrder);
 
-MetaSequencer combined;
+#ifdef SEQUENCER_CYCLE_CACHE
+CycleCache<SEQUENCER_CYCLE_CACHE_PERIOD, sizeof(chainOrder)> cycle(seqA, seqB, combined);
+#endif
+
+#ifdef SEQUENCER_COMBINE_OPERATION
+typedef CombinedSequence<SEQUENCER_BITS_TYPE, SEQUENCER_COMBINED_PERIOD> LogicSequence;
+LogicSequence logic(LogicSequence::SEQUENCER_COMBINE_OPERATION);
+#endif
 
 void reset(){
   seqA.reset();
   seqB.reset();
   combined.reset();
+#ifdef SEQUENCER_CYCLE_CACHE
+  cycle.reset();
+#endif
+#ifdef SEQUENCER_COMBINE_OPERATION
+  logic.reset();
+#endif
+}
+
+struct Preset {
+  uint16_t controls[ADC_CHANNELS];
+};
+
+// the last state, in slot 0: there is no control to save or recall others
+PresetStore<Preset> presets;
+Preset saved;
+uint16_t saveDelay;
+
+/* EEPROM ready interrupt */
+ISR(EE_READY_vect){
+  presets.writeNext();
+  DIAGNOSTICS_EXIT(DIAGNOSTICS_EE_READY);
+}
+
+void snapshot(Preset& preset){
+  preset.controls[SEQUENCER_ROTATE_A_CONTROL] = seqA.rotation.value;
+  preset.controls[SEQUENCER_STEP_A_CONTROL] = seqA.step.value;
+  preset.controls[SEQUENCER_FILL_A_CONTROL] = seqA.fill.value;
+  preset.controls[SEQUENCER_ROTATE_B_CONTROL] = seqB.rotation.value;
+  preset.controls[SEQUENCER_STEP_B_CONTROL] = seqB.step.value;
+  preset.controls[SEQUENCER_FILL_B_CONTROL] = seqB.fill.value;
+}
+
+void updateControls(){
+  seqA.rotation.update(getAnalogValue(SEQUENCER_ROTATE_A_CONTROL));
+  seqA.step.update(getAnalogValue(SEQUENCER_STEP_A_CONTROL));
+  seqA.fill.update(getAnalogValue(SEQUENCER_FILL_A_CONTROL));
+  seqA.update();
+
+  seqB.rotation.update(getAnalogValue(SEQUENCER_ROTATE_B_CONTROL));
+  seqB.step.update(getAnalogValue(SEQUENCER_STEP_B_CONTROL));
+  seqB.fill.update(getAnalogValue(SEQUENCER_FILL_B_CONTROL));
+  seqB.update();
+}
+
+#ifdef SEQUENCER_INPUT_LOG
+InputLog inputLog;
+
+ISR(TIMER1_OVF_vect){
+  inputLog.overflow();
+  DIAGNOSTICS_EXIT(DIAGNOSTICS_TIMER1_OVF);
+}
+
+uint8_t readSwitches(){
+  uint8_t state = 0;
+  if(seqA.isTriggering())
+    state |= INPUT_LOG_SWITCH_TRIGGER_A;
+  if(seqA.isAlternating())
+    state |= INPUT_LOG_SWITCH_ALTERNATE_A;
+  if(seqB.isTriggering())
+    state |= INPUT_LOG_SWITCH_TRIGGER_B;
+  if(seqB.isAlternating())
+    state |= INPUT_LOG_SWITCH_ALTERNATE_B;
+  if(isChained())
+    state |= INPUT_LOG_SWITCH_CHAINED;
+  return state;
 }
+#endif /* SEQUENCER_INPUT_LOG */
 
 /* Reset interrupt */
 SIGNAL(INT0_vect){
+  PROFILE_SCOPE(PROFILE_INT0);
+#ifdef SEQUENCER_INPUT_LOG
+  inputLog.edge(INPUT_LOG_RESET, 1);
+#endif
   reset();
   // hold everything until reset is released
   while(resetIsHigh());
+#ifdef SEQUENCER_INPUT_LOG
+  inputLog.edge(INPUT_LOG_RESET, 0);
+#endif
+  DIAGNOSTICS_EXIT(DIAGNOSTICS_INT0);
 }
 
 #if SEQUENCER_CHAINED_SWITCH_PIN == SEQUENCER_CLOCK_PIN
@@ -88,29 +171,57 @@ SIGNAL(INT0_vect){
 
 /* Clock interrupt */
 SIGNAL(INT1_vect){
+  PROFILE_SCOPE(PROFILE_INT1);
   uint8_t mode = 
     (SEQUENCER_CHAINED_SWITCH_PINS & _BV(SEQUENCER_CHAINED_SWITCH_PIN)) |
     (SEQUENCER_CLOCK_PINS & _BV(SEQUENCER_CLOCK_PIN));
+#ifdef SEQUENCER_INPUT_LOG
+  inputLog.edge(INPUT_LOG_CLOCK,
+		(mode & _BV(SEQUENCER_CLOCK_PIN) ? 0 : INPUT_LOG_CLOCK_HIGH) |
+		(mode & _BV(SEQUENCER_CHAINED_SWITCH_PIN) ? 0 : INPUT_LOG_CHAINED));
+#endif
   switch(mode){
   case NORMAL_AND_LOW:
+#ifdef SEQUENCER_CYCLE_CACHE
+    cycle.fall(false);
+#else
     seqA.fall();
     seqB.fall();
+#endif
     SEQUENCER_LEDS_PORT &= ~_BV(SEQUENCER_LED_C_PIN);
     break;
   case NORMAL_AND_HIGH:
+#ifdef SEQUENCER_CYCLE_CACHE
+    cycle.rise(false);
+#else
     seqA.rise();
     seqB.rise();
+#endif
+#ifdef SEQUENCER_COMBINE_OPERATION
+    SEQUENCER_LEDS_PORT = (SEQUENCER_LEDS_PORT & ~_BV(SEQUENCER_LED_C_PIN)) |
+      (logic.next() << SEQUENCER_LED_C_PIN);
+#else
     SEQUENCER_LEDS_PORT |= _BV(SEQUENCER_LED_C_PIN);
+#endif
     break;
   case CHAINED_AND_LOW:
+#ifdef SEQUENCER_CYCLE_CACHE
+    cycle.fall(true);
+#else
     combined.fall();
+#endif
     SEQUENCER_LEDS_PORT &= ~_BV(SEQUENCER_LED_C_PIN);
     break;
   case CHAINED_AND_HIGH:
+#ifdef SEQUENCER_CYCLE_CACHE
+    cycle.rise(true);
+#else
     combined.rise();
+#endif
     SEQUENCER_LEDS_PORT |= _BV(SEQUENCER_LED_C_PIN);
     break;
   }
+  DIAGNOSTICS_EXIT(DIAGNOSTICS_INT1);
 }
 
 void setup(){
@@ -131,28 +242,74 @@ void setup(){
   SEQUENCER_CHAINED_SWITCH_DDR  &= ~_BV(SEQUENCER_CHAINED_SWITCH_PIN);
   SEQUENCER_CHAINED_SWITCH_PORT |= _BV(SEQUENCER_CHAINED_SWITCH_PIN);
   SEQUENCER_LEDS_DDR |= _BV(SEQUENCER_LED_C_PIN);
+  presets.begin();
+  bool restored = presets.recall(0, saved);
+  if(restored){
+    // start from the last state until the first ADC frame is complete,
+    // so that the first clock plays the right pattern
+    for(uint8_t i=0; i<ADC_CHANNELS; ++i)
+      adc_values[i] = saved.controls[i];
+    updateControls();
+  }
+#ifdef SEQUENCER_INPUT_LOG
+  inputLog.begin();
+  Preset boot;
+  snapshot(boot);
+  inputLog.update(readSwitches(), boot.controls);
+  inputLog.boot(restored);
+#endif
+#ifdef SEQUENCER_PROFILE
+  profiler.begin();
+#endif
+#ifdef SEQUENCER_LATENCY
+  latency.begin();
+#endif
   reset();
   sei();
 #ifdef SERIAL_DEBUG
   beginSerial(9600);
   printString("hello\n");
+#elif defined(SEQUENCER_DIAGNOSTICS) || defined(SEQUENCER_PROFILE) || defined(SEQUENCER_LATENCY)
+  beginSerial(9600);
 #endif
 }
 
 void loop(){
-  seqA.rotation.update(getAnalogValue(SEQUENCER_ROTATE_A_CONTROL));
-  seqA.step.update(getAnalogValue(SEQUENCER_STEP_A_CONTROL));
-  seqA.fill.update(getAnalogValue(SEQUENCER_FILL_A_CONTROL));
-  seqA.update();
+#ifdef SEQUENCER_INPUT_LOG
+  uint8_t switches = readSwitches();
+#endif
+  updateControls();
 
-  seqB.rotation.update(getAnalogValue(SEQUENCER_ROTATE_B_CONTROL));
-  seqB.step.update(getAnalogValue(SEQUENCER_STEP_B_CONTROL));
-  seqB.fill.update(getAnalogValue(SEQUENCER_FILL_B_CONTROL));
-  seqB.update();
+  // save the last state once the controls have settled
+  Preset current;
+  snapshot(current);
+#ifdef SEQUENCER_INPUT_LOG
+  inputLog.update(switches, current.controls);
+#endif
+  if(memcmp(&current, &saved, sizeof(Preset))){
+    saved = current;
+    saveDelay = PRESET_SAVE_DELAY;
+  }else if(saveDelay && !--saveDelay && !presets.save(0, saved)){
+    saveDelay = 1; // write in progress, try again
+  }
 
-#ifdef SERIAL_DEBUG
+#ifdef SEQUENCER_CYCLE_CACHE
+  cycle.update(isChained());
+#endif
+#ifdef SEQUENCER_COMBINE_OPERATION
+  // after the cache has moved the sequencers to its step; chained, they
+  // take turns, and the pattern is placed again back in normal mode
+  if(isChained())
+    logic.invalidate();
+  else
+    logic.update(seqA, seqB);
+#endif
+
+#if defined(SERIAL_DEBUG) || defined(SEQUENCER_DIAGNOSTICS) || defined(SEQUENCER_PROFILE) || defined(SEQUENCER_LATENCY)
   if(serialAvailable() > 0){
-    serialRead();
+    uint8_t command = serialRead();
+    (void)command; // only read by the 'c' of the counters
+#ifdef SERIAL_DEBUG
     printString("a: [");
     seqA.dump();
     printString("] ");
@@ -168,6 +325,22 @@ void loop(){
     if(isChained())
       printString(" chained");
     printNewline();
+#endif
+#ifdef SEQUENCER_DIAGNOSTICS
+    diagnostics.print();
+    if(command == 'c')
+      diagnostics.clear();
+#endif
+#ifdef SEQUENCER_PROFILE
+    profiler.print();
+    if(command == 'c')
+      profiler.clear();
+#endif
+#ifdef SEQUENCER_LATENCY
+    latency.print();
+    if(command == 'c')
+      latency.clear();
+#endif
   }
 #endif
 }
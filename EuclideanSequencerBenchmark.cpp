@@ -0,0 +1,114 @@
+/*
+make bench BENCHARGS="-j bench.json"
+
+Benchmarks the sequencing hot paths of the Stoicheia firmware on the host.
+usage: EuclideanSequencerBenchmark [-j file.json] [name filter]
+*/
+
+#include <stdlib.h>
+#include "benchmark.h"
+#include "EuclideanSequencer.cpp"
+#include "DiscreteController.h"
+#include "Bresenham.h"
+
+std::string name(const char* prefix, int a, int b){
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%s/%d/%d", prefix, a, b);
+  return buf;
+}
+
+/* every pattern of up to range steps */
+template<class Algorithm>
+void sweep(int8_t range){
+  for(int8_t s=1; s<=range; ++s){
+    for(int8_t f=0; f<=s; ++f){
+      Algorithm algo;
+      benchmarkKeep(algo.compute(s, f));
+    }
+  }
+}
+
+void setSwitches(GateSequencer::GateSequencerMode mode){
+  PIND |= _BV(SEQUENCER_TRIGGER_SWITCH_PIN_A) | _BV(SEQUENCER_ALTERNATE_SWITCH_PIN_A);
+  if(mode == GateSequencer::TRIGGERING)
+    PIND &= ~_BV(SEQUENCER_TRIGGER_SWITCH_PIN_A);
+  else if(mode == GateSequencer::ALTERNATING)
+    PIND &= ~_BV(SEQUENCER_ALTERNATE_SWITCH_PIN_A);
+  seqA.update();
+}
+
+int main(int argc, char** argv){
+  const char* json = NULL;
+  std::string filter;
+  for(int i=1; i<argc; ++i){
+    if(!strcmp(argv[i], "-j") && i+1 < argc)
+      json = argv[++i];
+    else
+      filter = argv[i];
+  }
+  Benchmark bench;
+#define BENCHMARK(title, body) \
+  if(std::string(title).find(filter) != std::string::npos) \
+    bench.run(title, [&](uint64_t n){ for(uint64_t i=0; i<n; ++i){ body; } })
+
+  sim_reset();
+  setup();
+  sim_drive(sim_portD, SEQUENCER_CLOCK_PIN, true);
+  sim_drive(sim_portD, SEQUENCER_RESET_PIN, true);
+
+  for(int steps=1; steps<=32; ++steps){
+    for(int fills=0; fills<=steps; ++fills){
+      Bjorklund<uint32_t, SEQUENCE_ALGORITHM_ARRAY_SIZE> algo;
+      volatile int8_t s = steps, f = fills;
+      BENCHMARK(name("bjorklund/compute", steps, fills), benchmarkKeep(algo.compute(s, f)));
+      Bresenham<uint32_t> walk;
+      BENCHMARK(name("bresenham/compute", steps, fills), benchmarkKeep(walk.compute(s, f)));
+    }
+  }
+  // every pattern of the knob range, as turning both knobs across it
+  typedef Bjorklund<uint32_t, SEQUENCE_ALGORITHM_ARRAY_SIZE> Bjorklund32;
+  volatile int8_t range = SEQUENCER_STEPS_RANGE;
+  BENCHMARK("bjorklund/sweep/" + std::to_string(SEQUENCER_STEPS_RANGE), sweep<Bjorklund32>(range));
+  BENCHMARK("bresenham/sweep/" + std::to_string(SEQUENCER_STEPS_RANGE), sweep<Bresenham<uint32_t> >(range));
+
+  Sequence<uint32_t> seq;
+  seq.calculate(13, 5);
+  BENCHMARK("sequence/next", benchmarkKeep(seq.next()));
+  BENCHMARK("sequence/rotate", seq.rotate(i & 15); benchmarkKeep(seq.pos));
+  BENCHMARK("sequence/reset", seq.reset(); benchmarkKeep(seq.pos));
+  BENCHMARK("sequence/calculate/32/13", seq.calculate(32, 13); benchmarkKeep(seq.bits));
+  Sequence<uint32_t, Bresenham<uint32_t> > walked;
+  BENCHMARK("sequence/calculate/bresenham/32/13", walked.calculate(32, 13); benchmarkKeep(walked.bits));
+
+  static const char* modes[] = { "disabled", "triggering", "alternating" };
+  for(int m=0; m<3; ++m){
+    setSwitches((GateSequencer::GateSequencerMode)m);
+    BENCHMARK(std::string("gatesequencer/rise/") + modes[m], seqA.rise());
+    BENCHMARK(std::string("gatesequencer/fall/") + modes[m], seqA.fall());
+  }
+
+  DeadbandController<SEQUENCER_DEADBAND_THRESHOLD> deadband;
+  deadband.value = 0;
+  BENCHMARK("deadband/update/changed", deadband.update(i & 1 ? 2000 : 0));
+  BENCHMARK("deadband/update/unchanged", deadband.update(i & 3));
+
+  DiscreteController discrete;
+  discrete.range = 8;
+  discrete.value = 0;
+  BENCHMARK("discrete/update", discrete.update((i * 97) & 4095));
+
+  setSwitches(GateSequencer::TRIGGERING);
+  BENCHMARK("firmware/INT1_vect", PIND ^= _BV(SEQUENCER_CLOCK_PIN); INT1_vect());
+  BENCHMARK("firmware/INT1_vect+loop", PIND ^= _BV(SEQUENCER_CLOCK_PIN); INT1_vect(); loop());
+
+  if(json){
+    FILE* out = fopen(json, "w");
+    if(!out){
+      perror(json);
+      return 1;
+    }
+    bench.writeJson(out);
+    fclose(out);
+  }
+  return 0;
+}
@@ -0,0 +1,256 @@
+/*
+make fuzz FUZZARGS="-max_total_time=60"
+
+Fuzzes the Stoicheia main loop against preemption by the clock and reset
+interrupts. Every SEQUENCER_YIELD() in the code called from loop() is a
+point where the fuzz input may raise a clock edge or a reset pulse, whose
+handlers then run right there, or as soon as interrupts are re-enabled.
+Wherever interrupts are enabled, both sequences must satisfy:
+  - 1 <= length <= SEQUENCER_STEPS_RANGE and pos < length
+  - no fills beyond the last step
+  - the bits are the Euclidean pattern of their length and fill count,
+    ie not the new length with the old bits or any other torn update
+  - a clock interrupt advances pos by exactly one step
+and after loop() the pattern has the steps and fills set by the knobs.
+Built with SEQUENCER_COMBINE_OPERATION, as EuclideanSequencerLogicFuzz,
+the combined pattern of LED C must also be whole wherever interrupts are
+enabled: that of the last loop(), or that of the current sequences.
+
+Input: a sequence of operations, each followed by a run of loop()
+  0-5: set ADC channel 0-5 to (next byte << 4 | op >> 4)
+  6:   set switch ((op >> 3) & 7) to (op >> 6) & 1, 4 is chained mode
+  7:   nothing
+one byte is taken at every yield point: bit 0 toggles the clock, bit 1
+pulses reset. Built with libFuzzer by make fuzz (clang), or with
+FUZZ_STANDALONE as a random input runner and reproducer:
+usage: EuclideanSequencerFuzz [-n runs] [-s seed] [input files]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+void fuzzYield();
+#define SEQUENCER_YIELD() fuzzYield()
+
+#include "EuclideanSequencer.cpp"
+
+#define FUZZ_RESET_CYCLES        64
+
+static const uint8_t* input;
+static size_t remaining;
+static bool preempting;
+static unsigned long yields;
+
+static uint8_t take(){
+  if(!remaining)
+    return 0;
+  remaining--;
+  return *input++;
+}
+
+static void fail(const char* what, GateSequencer& seq, char name){
+  fprintf(stderr, "fuzz: %s on %c: length %d, pos %d, offset %d, bits %08lx\n",
+	  what, name, seq.length, seq.pos, seq.offset, (unsigned long)seq.bits);
+  abort();
+}
+
+static uint8_t countFills(uint32_t bits){
+  uint8_t n = 0;
+  for(; bits; bits &= bits - 1)
+    n++;
+  return n;
+}
+
+static void check(GateSequencer& seq, char name){
+  if(seq.length < 1 || seq.length > SEQUENCER_STEPS_RANGE)
+    fail("length out of range", seq, name);
+  if(seq.pos >= seq.length)
+    fail("pos beyond length", seq, name);
+  uint32_t bits = seq.bits;
+  if(seq.length < 32 && (bits >> seq.length))
+    fail("fills beyond the last step", seq, name);
+  Bjorklund<SEQUENCER_BITS_TYPE, SEQUENCE_ALGORITHM_ARRAY_SIZE> algo;
+  if(algo.compute(seq.length, countFills(bits)) != seq.bits)
+    fail("torn pattern", seq, name);
+}
+
+/* the pattern matches the knobs, once loop() has run */
+static void checkControls(GateSequencer& seq, char name){
+  uint8_t s = SEQUENCER_STEPS_RANGE - (seq.step.value >> SEQUENCER_STEP_SCALING_FACTOR);
+  uint8_t f = s - ((seq.fill.value >> 2) * s) / (ADC_VALUE_RANGE >> 2);
+  if(seq.length != s || countFills(seq.bits) != f)
+    fail("fill count not preserved", seq, name);
+}
+
+#ifdef SEQUENCER_COMBINE_OPERATION
+static LogicSequence previous(LogicSequence::SEQUENCER_COMBINE_OPERATION);
+
+static bool plays(const LogicSequence& pattern){
+  if(logic.period != pattern.period)
+    return false;
+  for(uint16_t i=0; i<pattern.period; ++i)
+    if(logic.peek(i) != pattern.peek(i))
+      return false;
+  return true;
+}
+
+static void checkLogic(){
+  if(!logic.period || logic.period > SEQUENCER_COMBINED_PERIOD ||
+     logic.getPosition() >= logic.period){
+    fprintf(stderr, "fuzz: combined pos %d beyond period %d\n", logic.getPosition(), logic.period);
+    abort();
+  }
+  if(plays(previous))
+    return;
+  LogicSequence current(LogicSequence::SEQUENCER_COMBINE_OPERATION);
+  current.calculate(seqA, seqB);
+  if(!plays(current)){
+    fprintf(stderr, "fuzz: torn combined pattern, period %d\n", logic.period);
+    abort();
+  }
+}
+#endif /* SEQUENCER_COMBINE_OPERATION */
+
+static void checkAll(){
+  check(seqA, 'A');
+  check(seqB, 'B');
+#ifdef SEQUENCER_COMBINE_OPERATION
+  bool nested = preempting;
+  preempting = true; // no yields in the reference calculation
+  checkLogic();
+  preempting = nested;
+#endif
+}
+
+void fuzzYield(){
+  if(preempting)
+    return;
+  yields++;
+  if(sim_interrupts)
+    checkAll();
+  uint8_t action = take();
+  preempting = true;
+  if((action & 1) && !(EIFR & _BV(INTF1))){
+    uint8_t posA = seqA.pos, posB = seqB.pos;
+    uint16_t counterA = seqA.counter, counterB = seqB.counter;
+    bool immediate = sim_interrupts;
+    sim_drive(sim_portD, SEQUENCER_CLOCK_PIN, !(sim_portD.input & _BV(SEQUENCER_CLOCK_PIN)));
+    if(immediate){
+      if(seqA.counter != counterA && seqA.pos != (posA + 1) % seqA.length)
+	fail("clock skipped a step", seqA, 'A');
+      if(seqB.counter != counterB && seqB.pos != (posB + 1) % seqB.length)
+	fail("clock skipped a step", seqB, 'B');
+    }
+  }
+  if((action & 2) && !(EIFR & _BV(INTF0))){
+    sim_schedule(sim_cycles + FUZZ_RESET_CYCLES, sim_portD, SEQUENCER_RESET_PIN, true);
+    sim_drive(sim_portD, SEQUENCER_RESET_PIN, false);
+  }
+  preempting = false;
+  if(sim_interrupts)
+    checkAll();
+}
+
+/* puts the firmware back into its power on state */
+static void start(){
+  sim_reset();
+  sim_erase_eeprom();
+  seqA.~GateSequencer();
+  new (&seqA) GateSequencer(SEQUENCER_OUTPUT_PIN_A, SEQUENCER_TRIGGER_SWITCH_PIN_A,
+			    SEQUENCER_ALTERNATE_SWITCH_PIN_A, SEQUENCER_LED_A_PIN);
+  seqB.~GateSequencer();
+  new (&seqB) GateSequencer(SEQUENCER_OUTPUT_PIN_B, SEQUENCER_TRIGGER_SWITCH_PIN_B,
+			    SEQUENCER_ALTERNATE_SWITCH_PIN_B, SEQUENCER_LED_B_PIN);
+  for(uint8_t i=0; i<2; ++i){
+    channels[i]->bits = 0;
+    channels[i]->step.value = 0;
+    channels[i]->fill.value = 0;
+    channels[i]->rotation.value = 0;
+  }
+  new (&combined) ChainedSequencer<2, sizeof(chainOrder)>(channels, chainOrder);
+#ifdef SEQUENCER_COMBINE_OPERATION
+  new (&logic) LogicSequence(LogicSequence::SEQUENCER_COMBINE_OPERATION);
+  previous = logic;
+#endif
+  new (&presets) PresetStore<Preset>();
+  memset(&saved, 0, sizeof(saved));
+  saveDelay = 0;
+  for(uint8_t i=0; i<ADC_CHANNELS; ++i)
+    adc_values[i] = 0;
+  setup();
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size){
+  input = data;
+  remaining = size;
+  start();
+  while(remaining){
+    uint8_t op = take();
+    switch(op & 7){
+    case 6:
+      if(((op >> 3) & 7) == 4)
+	sim_drive(sim_portB, SEQUENCER_CHAINED_SWITCH_PIN, (op >> 6) & 1);
+      else
+	sim_drive(sim_portD, PORTD4 + ((op >> 3) & 3), (op >> 6) & 1);
+      break;
+    case 7:
+      break;
+    default:
+      adc_values[op & 7] = (take() << 4) | (op >> 4);
+      break;
+    }
+    loop();
+    checkAll();
+    checkControls(seqA, 'A');
+    checkControls(seqB, 'B');
+#ifdef SEQUENCER_COMBINE_OPERATION
+    previous = logic;
+#endif
+  }
+  return 0;
+}
+
+#ifdef FUZZ_STANDALONE
+static void runFile(const char* file){
+  FILE* in = fopen(file, "rb");
+  if(!in){
+    fprintf(stderr, "fuzz: cannot read %s\n", file);
+    exit(1);
+  }
+  static uint8_t data[1 << 16];
+  size_t size = fread(data, 1, sizeof(data), in);
+  fclose(in);
+  LLVMFuzzerTestOneInput(data, size);
+}
+
+int main(int argc, char** argv){
+  unsigned long runs = 100000;
+  unsigned int seed = 1;
+  int i = 1;
+  for(; i<argc && argv[i][0] == '-'; ++i){
+    if(!strcmp(argv[i], "-n") && i+1 < argc)
+      runs = strtoul(argv[++i], NULL, 0);
+    else if(!strcmp(argv[i], "-s") && i+1 < argc)
+      seed = strtoul(argv[++i], NULL, 0);
+  }
+  if(i < argc){
+    int files = argc - i;
+    for(; i<argc; ++i)
+      runFile(argv[i]);
+    printf("%d inputs, %lu yields\n", files, yields);
+    return 0;
+  }
+  srand(seed);
+  uint8_t data[512];
+  for(unsigned long n=0; n<runs; ++n){
+    size_t size = rand() % sizeof(data);
+    for(size_t j=0; j<size; ++j)
+      data[j] = rand();
+    LLVMFuzzerTestOneInput(data, size);
+  }
+  printf("%lu runs, %lu yields\n", runs, yields);
+  return 0;
+}
+#endif /* FUZZ_STANDALONE */
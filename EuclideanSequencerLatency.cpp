@@ -0,0 +1,168 @@
+/*
+make latency LATENCYARGS="-n 10000 -p 8000 -l 3000"
+
+Measures the Stoicheia knob to pattern latency in the host simulation:
+steps the channel A step knob to a new position at a random phase of
+the ADC frames, loop() and the clock, and times the first ADC frame that
+sees the step (adc), the update in loop() to the pattern of the new knob
+position (ready) and the first clock edge that plays it (played). Prints the percentiles of
+each in microseconds. loop() runs at the start of each loop period, so
+the loop period stands for the time loop() takes on the target, which a
+SEQUENCER_PROFILE build measures.
+
+usage: EuclideanSequencerLatency [-n trials] [-p cycles per half clock period]
+                                 [-l cycles per loop] [-s seed]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <algorithm>
+#include <vector>
+
+void latencyInput(uint16_t before, uint16_t after);
+void latencyReady();
+void latencyPlayed();
+#define LATENCY_INPUT(before, after) latencyInput(before, after)
+#define LATENCY_READY()              latencyReady()
+#define LATENCY_PLAYED()             latencyPlayed()
+
+#include "EuclideanSequencer.cpp"
+
+#define LATENCY_TIMEOUT_CYCLES   (F_CPU / 2)
+/* a few ADC frames, for the controls to settle between trials */
+#define LATENCY_SETTLE_CYCLES    (F_CPU / 100)
+#define CYCLES_PER_US            (F_CPU / 1000000UL)
+
+static bool armed;
+static uint8_t target;
+static uint64_t stepAt, adcAt, readyAt, playedAt;
+static uint64_t nextEdge;
+static uint32_t halfPeriod = 8000;
+static uint32_t loopCycles = 2000;
+
+/* the simulated inputs have no noise, so any change is the step */
+void latencyInput(uint16_t before, uint16_t after){
+  if(armed && !adcAt && after != before)
+    adcAt = sim_cycles;
+}
+
+/* a frame that straddles the step can set a pattern in between first */
+void latencyReady(){
+  if(armed && !readyAt && seqA.length == target)
+    readyAt = sim_cycles;
+}
+
+void latencyPlayed(){
+  if(armed && readyAt && !playedAt)
+    playedAt = sim_cycles;
+}
+
+/* runs the peripherals and the clock up to a cycle, the handlers' pin
+   reads may already have taken the time past it */
+static void runTo(uint64_t cycle){
+  if(cycle > sim_cycles)
+    sim_run(cycle - sim_cycles);
+}
+
+static void advance(uint64_t until){
+  while(nextEdge <= until){
+    runTo(nextEdge);
+    // inputs are inverted: driving the pin low is a high clock
+    sim_drive(sim_portD, SEQUENCER_CLOCK_PIN, !(sim_portD.input & _BV(SEQUENCER_CLOCK_PIN)));
+    nextEdge += halfPeriod;
+  }
+  runTo(until);
+}
+
+static void step(){
+  loop();
+  advance(sim_cycles + loopCycles);
+}
+
+static void report(const char* name, std::vector<uint64_t>& cycles){
+  printf("%-8s", name);
+  if(cycles.empty()){
+    printf("\n");
+    return;
+  }
+  std::sort(cycles.begin(), cycles.end());
+  static const unsigned percentiles[] = { 0, 50, 90, 99, 100 };
+  for(unsigned p : percentiles){
+    size_t rank = (cycles.size() * p + 99) / 100;
+    uint64_t c = cycles[rank ? rank - 1 : 0];
+    printf(" %10.1f", (double)c / CYCLES_PER_US);
+  }
+  printf("\n");
+}
+
+int main(int argc, char** argv){
+  unsigned long trials = 1000;
+  unsigned int seed = 1;
+  for(int i=1; i<argc; ++i){
+    if(!strcmp(argv[i], "-n") && i+1 < argc)
+      trials = strtoul(argv[++i], NULL, 0);
+    else if(!strcmp(argv[i], "-p") && i+1 < argc)
+      halfPeriod = strtoul(argv[++i], NULL, 0);
+    else if(!strcmp(argv[i], "-l") && i+1 < argc)
+      loopCycles = strtoul(argv[++i], NULL, 0);
+    else if(!strcmp(argv[i], "-s") && i+1 < argc)
+      seed = strtoul(argv[++i], NULL, 0);
+    else{
+      fprintf(stderr, "usage: %s [-n trials] [-p cycles per half clock period] [-l cycles per loop] [-s seed]\n", argv[0]);
+      return 1;
+    }
+  }
+  if(!halfPeriod || !loopCycles){
+    fprintf(stderr, "latency: the clock and loop periods must not be 0\n");
+    return 1;
+  }
+  srand(seed);
+  sim_reset();
+  sim_erase_eeprom();
+  for(uint8_t i=0; i<ADC_CHANNELS; ++i)
+    sim_analog(i, rand() & 1023);
+  sim_drive(sim_portD, SEQUENCER_RESET_PIN, true); // reset low
+  sim_drive(sim_portD, SEQUENCER_CLOCK_PIN, true); // clock low
+  sim_drive(sim_portD, SEQUENCER_TRIGGER_SWITCH_PIN_A, false); // triggering
+  setup();
+  nextEdge = halfPeriod;
+
+  std::vector<uint64_t> adc, ready, played;
+  unsigned long dropped = 0;
+  for(unsigned long n=0; n<trials; ++n){
+    // a random phase of the ADC frame, loop() and the clock
+    uint64_t settled = sim_cycles + LATENCY_SETTLE_CYCLES + rand() % LATENCY_SETTLE_CYCLES;
+    while(sim_cycles < settled)
+      step();
+    advance(sim_cycles + rand() % loopCycles);
+    // the middle of the control range of a different step count
+    do
+      target = 1 + rand() % SEQUENCER_STEPS_RANGE;
+    while(target == seqA.length);
+    uint16_t value = ((SEQUENCER_STEPS_RANGE - target) << SEQUENCER_STEP_SCALING_FACTOR) +
+      (1 << (SEQUENCER_STEP_SCALING_FACTOR - 1));
+    adcAt = readyAt = playedAt = 0;
+    stepAt = sim_cycles;
+    armed = true;
+    sim_analog(SEQUENCER_STEP_A_CONTROL, value / ADC_OVERSAMPLING);
+    while(!playedAt && sim_cycles - stepAt < LATENCY_TIMEOUT_CYCLES)
+      step();
+    armed = false;
+    if(!playedAt){
+      dropped++;
+      continue;
+    }
+    adc.push_back(adcAt - stepAt);
+    ready.push_back(readyAt - stepAt);
+    played.push_back(playedAt - stepAt);
+  }
+  printf("trials %lu, dropped %lu, clock period %.1fus, loop %.1fus\n", trials, dropped,
+	 2.0 * halfPeriod / CYCLES_PER_US, (double)loopCycles / CYCLES_PER_US);
+  printf("us            min        p50        p90        p99        max\n");
+  report("adc", adc);
+  report("ready", ready);
+  report("played", played);
+  return dropped ? 1 : 0;
+}
@@ -1,5 +1,5 @@
 /*
-g++ -I../RebelTechnology/Libraries/wiring -I../RebelTechnology/Libraries/avrsim -I/opt/local/include -L/opt/local/lib -o EuclideanSequencerTest -lboost_unit_test_framework  EuclideanSequencerTest.cpp ../RebelTechnology/Libraries/avrsim/avr/io.c ../RebelTechnology/Libraries/wiring/serial.c ../RebelTechnology/Libraries/avrsim/avr/interrupt.c && ./EuclideanSequencerTest
+make build/sim/EuclideanSequencerTest && ./build/sim/EuclideanSequencerTest
 */
 
 #define SERIAL_DEBUG
@@ -0,0 +1,94 @@
+#ifndef _GATE_SEQUENCE_H_
+#define _GATE_SEQUENCE_H_
+
+#include "Sequence.h"
+
+/**
+   A Sequence driving a gate in one of the three modes. Gate is the
+   derived class, which provides on(), off() and toggle(): the output
+   port of the firmware, or a flag in the host library, so that both run
+   the same mode logic. Algorithm computes the pattern, as in Sequence.
+*/
+
+template<typename T, class Gate, class Algorithm = Bjorklund<T, SEQUENCE_ALGORITHM_ARRAY_SIZE> >
+class GateSequence : public Sequence<T, Algorithm> {
+public:
+  enum GateSequencerMode {
+    DISABLED                   =  0,
+    TRIGGERING                 =  1,
+    ALTERNATING                =  2
+  };
+
+  GateSequence() : mode(DISABLED) {}
+
+  void rise(){
+    play(this->next());
+  }
+  /* the gate for a step with or without a fill, eg from a cached cycle */
+  void play(bool fill){
+    switch(mode){
+    case TRIGGERING:
+      if(fill)
+	gate().on();
+      break;
+    case ALTERNATING:
+      if(fill)
+	gate().toggle();
+      break;
+    case DISABLED:
+      gate().off();
+      break;
+    }
+  }
+  void fall(){
+    switch(mode){
+    case DISABLED:
+    case TRIGGERING:
+      gate().off();
+      break;
+    case ALTERNATING:
+      break;
+    }
+  }
+  void reset(){
+    Sequence<T, Algorithm>::reset();
+    gate().off();
+  }
+
+protected:
+  volatile GateSequencerMode mode;
+
+private:
+  inline Gate& gate(){
+    return *static_cast<Gate*>(this);
+  }
+};
+
+/**
+   A GateSequence whose gate is a flag, for the host library and the
+   tests and benchmarks that check other implementations against it.
+*/
+template<typename T>
+class FlagGateSequence : public GateSequence<T, FlagGateSequence<T> > {
+public:
+  typedef typename GateSequence<T, FlagGateSequence<T> >::GateSequencerMode GateSequencerMode;
+
+  FlagGateSequence() : gate(false) {
+    this->bits = 0;
+  }
+  inline void on(){
+    gate = true;
+  }
+  inline void off(){
+    gate = false;
+  }
+  inline void toggle(){
+    gate = !gate;
+  }
+  void setMode(GateSequencerMode m){
+    this->mode = m;
+  }
+  bool gate;
+};
+
+#endif /* _GATE_SEQUENCE_H_ */
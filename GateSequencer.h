@@ -1,10 +1,28 @@
 #ifndef _GATE_SEQUENCER_H_
 #define _GATE_SEQUENCER_H_
 
-#include "Sequence.h"
+#include "GateSequence.h"
 #include "DeadbandController.h"
+#ifdef SEQUENCER_RHYTHM_CATALOGUE
+#include "RhythmCatalogue.h"
+#endif /* SEQUENCER_RHYTHM_CATALOGUE */
+#include "Latency.h"
+#ifdef SEQUENCER_BRESENHAM
+#include "Bresenham.h"
+#define SEQUENCER_ALGORITHM Bresenham<SEQUENCER_BITS_TYPE>
+#else
+#define SEQUENCER_ALGORITHM Bjorklund<SEQUENCER_BITS_TYPE, SEQUENCE_ALGORITHM_ARRAY_SIZE>
+#endif /* SEQUENCER_BRESENHAM */
+#ifdef SEQUENCER_TRACE
+#include "trace.h"
+#else
+#define SEQUENCER_TRACE_CHANNEL(output)
+#define SEQUENCER_TRACE_STEP(output, pos)
+#define SEQUENCER_TRACE_MODE(output, mode)
+#define SEQUENCER_TRACE_SEGMENT(index)
+#endif /* SEQUENCER_TRACE */
 
-class GateSequencer : public Sequence<SEQUENCER_BITS_TYPE> {
+class GateSequencer : public GateSequence<SEQUENCER_BITS_TYPE, GateSequencer, SEQUENCER_ALGORITHM> {
 public:
 
   class SequenceController : public DeadbandController<SEQUENCER_DEADBAND_THRESHOLD> {
@@ -23,15 +41,10 @@ public:
     void hasChanged(uint16_t val){
       val >>= 8; // scale 0-4095 down to 0-15
       seq->rotate(val);
+      LATENCY_READY();
     }
   };
 
-  enum GateSequencerMode {
-    DISABLED                   =  0,
-    TRIGGERING                 =  1,
-    ALTERNATING                =  2
-  };
-
 public:
   SequenceController step;
   SequenceController fill;
@@ -39,7 +52,7 @@ public:
   bool recalculate;
 
   GateSequencer(uint8_t p1, uint8_t p2, uint8_t p3, uint8_t p4):
-    step(this), fill(this), rotation(this), mode(DISABLED), recalculate(true),
+    step(this), fill(this), rotation(this), recalculate(true),
     output(p1), trigger(p2), alternate(p3), led(p4){
 #ifdef SEQUENCER_TRIGGER_SWITCH_PINS
     SEQUENCER_TRIGGER_SWITCH_DDR &= ~_BV(trigger);
@@ -51,19 +64,27 @@ public:
     SEQUENCER_LEDS_DDR |= _BV(led);
     SEQUENCER_LEDS_PORT |= _BV(led);
     off();
+    SEQUENCER_TRACE_CHANNEL(output);
   }
   void update(){
+    PROFILE_SCOPE(PROFILE_UPDATE);
     if(recalculate){
+#ifdef SEQUENCER_RHYTHM_CATALOGUE
+      load(((uint32_t)step.value * RHYTHM_CATALOGUE_ENTRIES) / ADC_VALUE_RANGE, fill.value);
+#else
       uint8_t s = SEQUENCER_STEPS_RANGE - (step.value >> SEQUENCER_STEP_SCALING_FACTOR);
       uint8_t f = s - ((fill.value >> 2) * s) / (ADC_VALUE_RANGE >> 2);
       calculate(s, f);
-      recalculate = false;
 #ifdef SERIAL_DEBUG
       printInteger(s);
       printByte('.');
       printInteger(f);
       printNewline();
 #endif
+#endif /* SEQUENCER_RHYTHM_CATALOGUE */
+      recalculate = false;
+      LATENCY_READY();
+      SEQUENCER_YIELD();
     }
     if(isTriggering())
       mode = TRIGGERING;
@@ -71,7 +92,26 @@ public:
       mode = ALTERNATING;
     else
       mode = DISABLED;
+    SEQUENCER_TRACE_MODE(output, mode);
   }
+#ifdef SEQUENCER_RHYTHM_CATALOGUE
+  /* load a catalogue rhythm without running the Bjorklund algorithm,
+     started on the onset that a knob value selects */
+  void load(uint8_t index, uint16_t value){
+    uint8_t steps = getRhythmSteps(index, channel());
+    uint32_t bits = getRhythmBits(index, channel());
+    uint8_t onset = ((uint32_t)value * getRhythmOnsets(bits)) / ADC_VALUE_RANGE;
+    set(steps, getRhythmOnset(bits, steps, onset));
+  }
+  /* 0 for A, 1 for B, the channel of a pattern bank entry to play */
+  inline uint8_t channel(){
+#ifdef SEQUENCER_OUTPUT_PIN_B
+    return output == SEQUENCER_OUTPUT_PIN_B;
+#else
+    return 0;
+#endif
+  }
+#endif /* SEQUENCER_RHYTHM_CATALOGUE */
   void push(GateSequencer& seq){
     if(isOn())
       seq.on();
@@ -79,34 +119,20 @@ public:
       seq.off();
   }
   void rise(){
-    switch(mode){
-    case TRIGGERING:
-      if(next())
-	on();
-      break;
-    case ALTERNATING:
-      if(next())
-	toggle();
-      break;
-    case DISABLED:
-      next();
-      off();
-      break;
-    }
+    SEQUENCER_TRACE_STEP(output, pos);
+    LATENCY_PLAYED();
+    GateSequence<SEQUENCER_BITS_TYPE, GateSequencer, SEQUENCER_ALGORITHM>::rise();
   }
-  void fall(){
-    switch(mode){
-    case DISABLED:
-    case TRIGGERING:
-      off();
-      break;
-    case ALTERNATING:
-      break;
-    }
+  /* plays a step with or without a fill, at position step of the
+     pattern, as rise() does, eg from a cached cycle */
+  void play(bool fill, uint8_t step){
+    SEQUENCER_TRACE_STEP(output, step);
+    LATENCY_PLAYED();
+    GateSequence<SEQUENCER_BITS_TYPE, GateSequencer, SEQUENCER_ALGORITHM>::play(fill);
   }
   void reset(){
-    Sequence<SEQUENCER_BITS_TYPE>::reset();
-    off();
+    GateSequence<SEQUENCER_BITS_TYPE, GateSequencer, SEQUENCER_ALGORITHM>::reset();
+    SEQUENCER_TRACE_STEP(output, pos);
   }
   inline void on(){
     SEQUENCER_OUTPUT_PORT &= ~_BV(output);
@@ -167,8 +193,6 @@ private:
   uint8_t trigger;
   uint8_t alternate;
   uint8_t led;
-  volatile GateSequencerMode mode;
-
 };
 
 #endif /* _GATE_SEQUENCER_H_ */
@@ -0,0 +1,54 @@
+/*
+make build/sim/GoldenPatternTest && ./build/sim/GoldenPatternTest
+*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Test
+#include <boost/test/unit_test.hpp>
+#include <stdio.h>
+#include "golden.h"
+
+std::vector<uint8_t> readCorpus(const char* file){
+  std::vector<uint8_t> data;
+  FILE* in = fopen(file, "rb");
+  if(in){
+    uint8_t buf[4096];
+    size_t len;
+    while((len = fread(buf, 1, sizeof(buf), in)) > 0)
+      data.insert(data.end(), buf, buf+len);
+    fclose(in);
+  }
+  return data;
+}
+
+/* describes the entry at an offset into the block for n steps */
+void describe(uint8_t n, size_t offset){
+  size_t pattern = (n+7)/8;
+  size_t gates = (n+1)/2;
+  size_t fill = pattern + n * GOLDEN_MODES * gates;
+  int f = offset / fill;
+  offset %= fill;
+  if(offset < pattern){
+    BOOST_ERROR("pattern differs: steps " << (int)n << " fills " << f);
+  }else{
+    offset = (offset - pattern) / gates;
+    BOOST_ERROR("gates differ: steps " << (int)n << " fills " << f <<
+		" rotation " << offset / GOLDEN_MODES << " mode " << offset % GOLDEN_MODES);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testGoldenCorpus){
+  std::vector<uint8_t> golden = readCorpus("golden.bin");
+  BOOST_REQUIRE_MESSAGE(golden.size() > GOLDEN_HEADER_SIZE, "cannot read golden.bin");
+  std::vector<uint8_t> corpus = goldenCorpus();
+  BOOST_REQUIRE(std::equal(corpus.begin(), corpus.begin()+GOLDEN_HEADER_SIZE, golden.begin()));
+  BOOST_REQUIRE_EQUAL(corpus.size(), golden.size());
+  for(uint8_t n=1; n<=GOLDEN_MAX_STEPS; ++n){
+    size_t start = goldenOffset(n);
+    for(size_t i=0; i<goldenBlockSize(n); ++i){
+      if(corpus[start+i] != golden[start+i]){
+	describe(n, i);
+	break;
+      }
+    }
+  }
+}
@@ -0,0 +1,195 @@
+#ifndef _INPUT_LOG_H_
+#define _INPUT_LOG_H_
+
+#include <inttypes.h>
+#include <avr/io.h>
+#include <util/atomic.h>
+#include "serial.h"
+
+/**
+   Streaming log of the inputs as the firmware saw them, written to the
+   serial port so that a session can be replayed on the host.
+
+   The log starts with a header: 'E' 'U' 'I' 'N', the version, and the
+   number of CPU cycles per tick as a varint. Then each record is:
+     one byte: type << 4 | flags
+     varint: ticks since the previous record
+     payload, depending on the type:
+   CLOCK     flags: 1 clock high, 2 chained, as read by the clock interrupt
+   RESET     flags: 1 reset high at the start, 0 at the release of reset
+   SWITCHES  one byte of INPUT_LOG_SWITCH_* bits, when loop() sees a change
+             and on its first pass
+   CONTROLS  a byte with a bit per ADC channel, then for each channel set
+             the change of its control value as a zigzag varint, when
+             loop() accepts a new control value
+   A SWITCHES record directly followed by a CONTROLS record comes from the
+   same pass of loop(), and edges are written before the pass that
+   follows them.
+   BOOT      flags: 1 if setup() restored the controls from a preset;
+             the SWITCHES and CONTROLS before it are the state at boot
+   DROPPED   varint: the number of clock and reset edges lost, at the
+             time of the next edge that was not, because loop() did not
+             empty the queue in time; the log is then incomplete
+   Varints are little endian base 128. Ticks are Timer1 counts at a
+   prescaler of INPUT_LOG_PRESCALER, extended to 32 bits by the overflow
+   interrupt.
+*/
+
+#define INPUT_LOG_VERSION        2
+#define INPUT_LOG_PRESCALER      64
+#define INPUT_LOG_BAUD           115200
+#define INPUT_LOG_QUEUE_SIZE     16
+
+#define INPUT_LOG_CLOCK          1
+#define INPUT_LOG_RESET          2
+#define INPUT_LOG_SWITCHES       3
+#define INPUT_LOG_CONTROLS       4
+#define INPUT_LOG_BOOT           5
+#define INPUT_LOG_DROPPED        6
+
+#define INPUT_LOG_CLOCK_HIGH     1
+#define INPUT_LOG_CHAINED        2
+
+#define INPUT_LOG_SWITCH_TRIGGER_A     1
+#define INPUT_LOG_SWITCH_ALTERNATE_A   2
+#define INPUT_LOG_SWITCH_TRIGGER_B     4
+#define INPUT_LOG_SWITCH_ALTERNATE_B   8
+#define INPUT_LOG_SWITCH_CHAINED       16
+
+class InputLog {
+public:
+  InputLog() : overflows(0), head(0), tail(0), dropped(0), last(0), switchState(0) {
+    for(uint8_t i=0; i<ADC_CHANNELS; ++i)
+      values[i] = 0;
+  }
+
+  /* starts Timer1 and writes the header, call from setup() */
+  void begin(){
+    beginSerial(INPUT_LOG_BAUD);
+    TCCR1A = 0;
+    TCCR1B = _BV(CS11) | _BV(CS10); // prescaler 64
+    TCNT1 = 0;
+    TIMSK1 |= _BV(TOIE1);
+    serialWrite('E');
+    serialWrite('U');
+    serialWrite('I');
+    serialWrite('N');
+    serialWrite(INPUT_LOG_VERSION);
+    varint(INPUT_LOG_PRESCALER);
+  }
+
+  /* called from TIMER1_OVF_vect */
+  void overflow(){
+    overflows++;
+  }
+
+  /* 32-bit tick count */
+  uint32_t now(){
+    uint32_t t;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+      uint16_t low = TCNT1;
+      uint16_t high = overflows;
+      // an overflow that has not been handled yet
+      if((TIFR1 & _BV(TOV1)) && low < 0x8000)
+	high++;
+      t = ((uint32_t)high << 16) | low;
+    }
+    return t;
+  }
+
+  /* queues an edge, called from the interrupt handlers */
+  void edge(uint8_t type, uint8_t flags){
+    uint8_t next = (head + 1) % INPUT_LOG_QUEUE_SIZE;
+    if(next == tail){
+      // loop() is not keeping up, counted for the next edge
+      if(dropped < 0xff)
+	dropped++;
+      return;
+    }
+    queue[head].time = now();
+    queue[head].type = (type << 4) | flags;
+    queue[head].dropped = dropped;
+    dropped = 0;
+    head = next;
+  }
+
+  /* writes the queued edges, and the switches and controls if they have
+     changed, called from loop() after the controls have been updated */
+  void update(uint8_t state, const uint16_t* v){
+    flush();
+    uint32_t time = now();
+    if(state != switchState){
+      record(INPUT_LOG_SWITCHES << 4, time);
+      serialWrite(state);
+      switchState = state;
+    }
+    uint8_t changed = 0;
+    for(uint8_t i=0; i<ADC_CHANNELS; ++i)
+      if(v[i] != values[i])
+	changed |= _BV(i);
+    if(changed){
+      record(INPUT_LOG_CONTROLS << 4, time);
+      serialWrite(changed);
+      for(uint8_t i=0; i<ADC_CHANNELS; ++i){
+	if(changed & _BV(i)){
+	  int16_t delta = v[i] - values[i];
+	  varint(((uint16_t)delta << 1) ^ (delta >> 15));
+	  values[i] = v[i];
+	}
+      }
+    }
+  }
+
+  void boot(bool restored){
+    record((INPUT_LOG_BOOT << 4) | restored, now());
+    // the first pass of loop() applies the switches, so it is always logged
+    switchState = 0xff;
+  }
+
+  /* writes the queued edges, called from loop() */
+  void flush(){
+    while(tail != head){
+      if(queue[tail].dropped){
+	record(INPUT_LOG_DROPPED << 4, queue[tail].time);
+	varint(queue[tail].dropped);
+      }
+      record(queue[tail].type, queue[tail].time);
+      tail = (tail + 1) % INPUT_LOG_QUEUE_SIZE;
+    }
+  }
+
+private:
+  struct Edge {
+    uint32_t time;
+    uint8_t type;
+    uint8_t dropped;
+  };
+
+  void record(uint8_t type, uint32_t time){
+    // an edge queued after this record was timed is written before it
+    if((int32_t)(time - last) < 0)
+      time = last;
+    serialWrite(type);
+    varint(time - last);
+    last = time;
+  }
+
+  void varint(uint32_t value){
+    while(value >= 0x80){
+      serialWrite((value & 0x7f) | 0x80);
+      value >>= 7;
+    }
+    serialWrite(value);
+  }
+
+  volatile uint16_t overflows;
+  Edge queue[INPUT_LOG_QUEUE_SIZE];
+  volatile uint8_t head;
+  volatile uint8_t tail;
+  volatile uint8_t dropped;
+  uint32_t last;
+  uint8_t switchState;
+  uint16_t values[ADC_CHANNELS];
+};
+
+#endif /* _INPUT_LOG_H_ */
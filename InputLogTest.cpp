@@ -0,0 +1,67 @@
+/*
+make build/sim/InputLogTest && ./build/sim/InputLogTest
+
+Tests that the input log of InputLog.h records the edges it drops when
+loop() does not empty its queue in time.
+*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Test
+#include <boost/test/unit_test.hpp>
+#include <stdio.h>
+#include <vector>
+#include "sim.h"
+#include "device.h"
+#include "InputLog.h"
+
+static uint32_t varint(const std::vector<uint8_t>& bytes, size_t& i){
+  uint32_t value = 0;
+  for(uint8_t shift=0; i < bytes.size(); shift+=7){
+    uint8_t c = bytes[i++];
+    value |= (uint32_t)(c & 0x7f) << shift;
+    if(!(c & 0x80))
+      break;
+  }
+  return value;
+}
+
+/* the records of a log, as (type, count) with the count of DROPPED */
+std::vector<std::pair<uint8_t, uint32_t> > records(FILE* f){
+  std::vector<uint8_t> bytes;
+  rewind(f);
+  for(int c; (c = getc(f)) != EOF; )
+    bytes.push_back(c);
+  std::vector<std::pair<uint8_t, uint32_t> > out;
+  size_t i = 5; // the magic and the version
+  varint(bytes, i); // the prescaler
+  while(i < bytes.size()){
+    uint8_t type = bytes[i++] >> 4;
+    varint(bytes, i); // the ticks
+    out.push_back(std::make_pair(type, type == INPUT_LOG_DROPPED ? varint(bytes, i) : 0));
+  }
+  return out;
+}
+
+BOOST_AUTO_TEST_CASE(testDroppedEdgesAreLogged){
+  sim_reset();
+  FILE* f = tmpfile();
+  BOOST_REQUIRE(f);
+  sim_serial_output(f);
+  InputLog log;
+  log.begin();
+  // the queue holds one edge fewer than its size, the rest are dropped
+  for(int i=0; i<INPUT_LOG_QUEUE_SIZE+3; ++i)
+    log.edge(INPUT_LOG_CLOCK, i & 1);
+  log.flush();
+  log.edge(INPUT_LOG_CLOCK, 0);
+  log.flush();
+  sim_serial_output(NULL);
+  fflush(f);
+  std::vector<std::pair<uint8_t, uint32_t> > r = records(f);
+  fclose(f);
+  BOOST_REQUIRE_EQUAL(r.size(), INPUT_LOG_QUEUE_SIZE + 1);
+  for(int i=0; i<INPUT_LOG_QUEUE_SIZE-1; ++i)
+    BOOST_CHECK_EQUAL(r[i].first, INPUT_LOG_CLOCK);
+  BOOST_CHECK_EQUAL(r[INPUT_LOG_QUEUE_SIZE-1].first, INPUT_LOG_DROPPED);
+  BOOST_CHECK_EQUAL(r[INPUT_LOG_QUEUE_SIZE-1].second, 4);
+  BOOST_CHECK_EQUAL(r[INPUT_LOG_QUEUE_SIZE].first, INPUT_LOG_CLOCK);
+}
@@ -0,0 +1,215 @@
+#ifndef _LATENCY_H_
+#define _LATENCY_H_
+
+/**
+   Knob to pattern latency of an instrumented build (SEQUENCER_LATENCY).
+   A measurement starts at the end of the first ADC frame in which a
+   control has moved by more than the deadband threshold, passes when
+   loop() sets the new pattern (ready) and ends at the first clock edge
+   that plays it. The physical move can precede that frame by up to one
+   frame, which the host simulation EuclideanSequencerLatency.cpp
+   measures from the true input step.
+
+   Times come from Timer1, free-running at a prescaler of 8 as for the
+   profiler, extended to 32 bits by its overflow interrupt. The end to
+   end latencies go into a histogram of quarter-octave buckets, from
+   which the serial report gives percentiles, at most 25% high. A move
+   that does not change the pattern within LATENCY_TIMEOUT_MS is counted
+   as dropped.
+
+   Every byte received on the serial port prints the report, and 'c' also
+   clears it.
+*/
+
+#ifdef SEQUENCER_LATENCY
+
+#ifdef SEQUENCER_INPUT_LOG
+#error The input log and the latency meter both use Timer1!
+#endif
+
+#include <inttypes.h>
+#include <avr/io.h>
+#include <util/atomic.h>
+#include "serial.h"
+
+#define LATENCY_TICKS_PER_US     (F_CPU / 8 / 1000000UL)
+#define LATENCY_TIMEOUT_MS       500
+#define LATENCY_UNIT_US          16
+#define LATENCY_BUCKETS          64
+
+#define LATENCY_INPUT(before, after) latency.input(before, after)
+#define LATENCY_READY()              latency.ready()
+#define LATENCY_PLAYED()             latency.played()
+
+class LatencyMeter {
+public:
+  LatencyMeter() : overflows(0), state(IDLE) {
+    clear();
+  }
+
+  /* starts Timer1 and its overflow interrupt, call from setup() */
+  void begin(){
+    TCCR1A = 0;
+    TCCR1B = _BV(CS11); // prescaler 8
+    TCNT1 = 0;
+    TIMSK1 |= _BV(TOIE1);
+  }
+
+  /* called from TIMER1_OVF_vect */
+  void overflow(){
+    overflows++;
+  }
+
+  /* 32-bit tick count */
+  uint32_t now(){
+    uint32_t t;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+      uint16_t low = TCNT1;
+      uint16_t high = overflows;
+      // an overflow that has not been handled yet
+      if((TIFR1 & _BV(TOV1)) && low < 0x8000)
+	high++;
+      t = ((uint32_t)high << 16) | low;
+    }
+    return t;
+  }
+
+  /* a channel of a completed ADC frame, called from ADC_vect */
+  inline void input(uint16_t before, uint16_t after){
+    if(state == IDLE){
+      int16_t delta = after - before;
+      if(delta >= SEQUENCER_DEADBAND_THRESHOLD || delta <= -SEQUENCER_DEADBAND_THRESHOLD){
+	start = now();
+	state = MOVED;
+      }
+    }else if(state == MOVED &&
+	     now() - start > LATENCY_TIMEOUT_MS * 1000UL * LATENCY_TICKS_PER_US){
+      dropped++;
+      state = IDLE;
+    }
+  }
+
+  /* a new pattern was set, called from loop() */
+  inline void ready(){
+    if(state == MOVED){
+      uint32_t t = now() - start;
+      readySum += t;
+      if(t > readyMax)
+	readyMax = t;
+      state = READY;
+    }
+  }
+
+  /* a clock edge, called from INT1_vect */
+  inline void played(){
+    if(state == READY){
+      uint32_t us = (now() - start) / LATENCY_TICKS_PER_US;
+      buckets[bucket(us / LATENCY_UNIT_US)]++;
+      count++;
+      if(us > max)
+	max = us;
+      state = IDLE;
+    }
+  }
+
+  void clear(){
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+      for(uint8_t i=0; i<LATENCY_BUCKETS; ++i)
+	buckets[i] = 0;
+      count = dropped = 0;
+      max = readySum = readyMax = 0;
+      state = IDLE;
+    }
+  }
+
+  /* count, dropped, ready mean and max, then end to end p50, p90, p99
+     and max, in us */
+  void print(){
+    uint16_t c, d;
+    uint32_t rs, rm, m;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+      c = count;
+      d = dropped;
+      rs = readySum;
+      rm = readyMax;
+      m = max;
+    }
+    printString("latency ");
+    printInteger(c);
+    printString(" dropped ");
+    printInteger(d);
+    if(c){
+      printString(" ready ");
+      printInteger(rs / c / LATENCY_TICKS_PER_US);
+      printByte('/');
+      printInteger(rm / LATENCY_TICKS_PER_US);
+      printString(" played ");
+      printInteger(percentile(c, 50));
+      printByte('/');
+      printInteger(percentile(c, 90));
+      printByte('/');
+      printInteger(percentile(c, 99));
+      printByte('/');
+      printInteger(m);
+    }
+    printNewline();
+  }
+
+private:
+  enum State { IDLE, MOVED, READY };
+
+  /* 4 linear buckets per octave */
+  static uint8_t bucket(uint32_t v){
+    if(v < 4)
+      return v;
+    uint8_t b = 2;
+    while(v >> (b + 1))
+      b++;
+    uint8_t i = (b - 1) * 4 + ((v >> (b - 2)) & 3);
+    return i < LATENCY_BUCKETS ? i : LATENCY_BUCKETS - 1;
+  }
+
+  /* upper bound of a bucket in us */
+  static uint32_t bound(uint8_t i){
+    if(i < 4)
+      return (i + 1) * LATENCY_UNIT_US;
+    uint8_t b = i / 4 + 1;
+    return (((4UL + (i & 3) + 1) << (b - 2)) * LATENCY_UNIT_US);
+  }
+
+  uint32_t percentile(uint16_t total, uint8_t p){
+    uint32_t rank = ((uint32_t)total * p + 99) / 100;
+    uint32_t seen = 0;
+    for(uint8_t i=0; i<LATENCY_BUCKETS; ++i){
+      ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+	seen += buckets[i];
+      }
+      if(seen >= rank)
+	return bound(i) < max ? bound(i) : max;
+    }
+    return max;
+  }
+
+  volatile uint16_t overflows;
+  volatile State state;
+  volatile uint32_t start;
+  volatile uint16_t buckets[LATENCY_BUCKETS];
+  volatile uint16_t count;
+  volatile uint16_t dropped;
+  volatile uint32_t max;
+  volatile uint32_t readySum;
+  volatile uint32_t readyMax;
+};
+
+extern LatencyMeter latency;
+
+#endif /* SEQUENCER_LATENCY */
+
+/* a harness may define its own, see EuclideanSequencerLatency.cpp */
+#ifndef LATENCY_INPUT
+#define LATENCY_INPUT(before, after)
+#define LATENCY_READY()
+#define LATENCY_PLAYED()
+#endif
+
+#endif /* _LATENCY_H_ */
@@ -0,0 +1,120 @@
+/*
+make build/sim/NecklaceIndexTest && ./build/sim/NecklaceIndexTest
+
+Tests the necklace index of lib/NecklaceIndex.h against Sequence.
+*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Test
+#include <boost/test/unit_test.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <type_traits>
+#include "lib/NecklaceIndex.h"
+
+typedef Sequence<uint64_t> Sequence64;
+
+/* the steps a sequencer plays from a reset */
+uint64_t played(uint8_t steps, uint8_t fills, uint8_t rotation){
+  Sequence64 seq;
+  seq.calculate(steps, fills);
+  seq.rotate(rotation);
+  seq.reset();
+  uint64_t bits = 0;
+  for(uint8_t i=0; i<steps; ++i)
+    bits |= (uint64_t)seq.next() << i;
+  return bits;
+}
+
+BOOST_AUTO_TEST_CASE(testCanonical){
+  uint8_t r;
+  // x-x--, its rotations and least rotation 00101 read from bit 4 down
+  BOOST_CHECK_EQUAL(NecklaceIndex::canonical(0x05, 5, r), 0x05);
+  BOOST_CHECK_EQUAL(r, 0);
+  BOOST_CHECK_EQUAL(NecklaceIndex::canonical(0x0a, 5, r), 0x05);
+  BOOST_CHECK_EQUAL(r, 1);
+  BOOST_CHECK_EQUAL(NecklaceIndex::canonical(0x12, 5, r), 0x05);
+  BOOST_CHECK_EQUAL(NecklaceIndex::rotate(0x12, 5, r), 0x05);
+  srand(3);
+  for(int t=0; t<2000; ++t){
+    uint8_t n = 1 + rand() % NECKLACE_MAX_STEPS;
+    uint64_t bits = (((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ rand()) & NecklaceIndex::mask(n);
+    uint64_t least = NecklaceIndex::canonical(bits, n, r);
+    BOOST_REQUIRE_EQUAL(NecklaceIndex::rotate(bits, n, r), least);
+    for(uint8_t i=0; i<n; ++i)
+      BOOST_REQUIRE(NecklaceIndex::rotate(bits, n, i) >= least);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testEveryRotationFound){
+  std::vector<uint8_t> data = NecklaceIndex::build();
+  NecklaceIndex index(&data[0], data.size());
+  BOOST_REQUIRE(index.isOpen());
+  for(uint8_t n=1; n<=NECKLACE_MAX_STEPS; ++n){
+    for(uint8_t k=0; k<=n; ++k){
+      for(uint8_t r=0; r<n; ++r){
+	uint64_t pattern = played(n, k, r);
+	NecklaceMatch match;
+	BOOST_REQUIRE_MESSAGE(index.lookup(pattern, n, match),
+			      "E(" << (int)k << ", " << (int)n << ") rotation " << (int)r);
+	BOOST_REQUIRE_EQUAL(match.steps, n);
+	BOOST_REQUIRE_EQUAL(match.fills, k);
+	// a periodic pattern has more than one rotation, any that plays it will do
+	BOOST_REQUIRE_EQUAL(played(match.steps, match.fills, match.rotation), pattern);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testNotEuclidean){
+  std::vector<uint8_t> data = NecklaceIndex::build();
+  NecklaceIndex index(&data[0], data.size());
+  NecklaceMatch match;
+  BOOST_CHECK(!index.lookup(0x03, 4, match)); // xx--
+  BOOST_CHECK(!index.lookup(0x0b, 8, match)); // xx-x----
+  BOOST_CHECK(!index.lookup(0x01, 0, match));
+  BOOST_CHECK(!index.lookup(0x01, NECKLACE_MAX_STEPS + 1, match));
+}
+
+BOOST_AUTO_TEST_CASE(testMappedFile){
+  std::vector<uint8_t> data = NecklaceIndex::build();
+  char file[] = "/tmp/necklacesXXXXXX";
+  int fd = mkstemp(file);
+  BOOST_REQUIRE(fd >= 0);
+  BOOST_REQUIRE_EQUAL(write(fd, &data[0], data.size()), (ssize_t)data.size());
+  ::close(fd);
+  NecklaceIndex index;
+  BOOST_REQUIRE(index.open(file));
+  NecklaceMatch match;
+  BOOST_REQUIRE(index.lookup(played(16, 5, 3), 16, match));
+  BOOST_CHECK_EQUAL(match.fills, 5);
+  BOOST_CHECK_EQUAL(match.rotation, 3);
+  index.close();
+  // a truncated file is not an index
+  BOOST_REQUIRE(!truncate(file, data.size() / 2));
+  BOOST_CHECK(!index.open(file));
+  unlink(file);
+}
+
+BOOST_AUTO_TEST_CASE(testLittleEndianLayout){
+  // the entries of up to 64 steps, in the smallest power of two slots
+  // that keeps the table at most half full
+  std::vector<uint8_t> data = NecklaceIndex::build();
+  const uint8_t slots[4] = { 0x00, 0x20, 0x00, 0x00 };
+  const uint8_t entries[4] = { 0x60, 0x08, 0x00, 0x00 };
+  BOOST_CHECK(!memcmp(&data[8], slots, 4));
+  BOOST_CHECK(!memcmp(&data[12], entries, 4));
+  BOOST_CHECK_EQUAL(data.size(), NECKLACE_HEADER_SIZE + 0x2000 * sizeof(NecklaceSlot));
+  // the necklace of E(1,64) is 1, in the first byte of its slot
+  const uint8_t one[8] = { 1, 0, 0, 0, 0, 0, 0, 0 };
+  bool found = false;
+  for(size_t i=NECKLACE_HEADER_SIZE; i<data.size(); i+=sizeof(NecklaceSlot)){
+    if(data[i+8] == 64 && data[i+9] == 1){
+      BOOST_CHECK(!memcmp(&data[i], one, 8));
+      found = true;
+    }
+  }
+  BOOST_CHECK(found);
+  BOOST_CHECK(!std::is_copy_constructible<NecklaceIndex>::value);
+  BOOST_CHECK(!std::is_copy_assignable<NecklaceIndex>::value);
+}
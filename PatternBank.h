@@ -0,0 +1,131 @@
+#ifndef _PATTERN_BANK_H_
+#define _PATTERN_BANK_H_
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <avr/pgmspace.h>
+
+/**
+   A bank of presets for both channels in one fixed binary layout, read
+   in place: from program memory on the module, where the bank is flashed
+   as the array of bank.h, and from an mmap()ed file on the host, where
+   pgm_read_* are plain loads (see lib/PatternBankFile.h). Every field
+   lies at a multiple of its size and words are little endian, the byte
+   order of both the AVR and x86, so the same bytes serve both.
+
+   Layout: a 16 byte header ("SBNK", version, channels, 0, 0, the number
+   of entries and of pattern words as 32-bit words), then the entries of
+   16 bytes, one PatternBankChannel per channel (steps, fills, rotation,
+   mode and the index of its pattern word) then a flags byte and 3 bytes
+   of 0, then the pattern words of 32 bits, step i in bit i. Entries with
+   the same pattern share its word.
+*/
+
+#define PATTERN_BANK_VERSION     1
+#define PATTERN_BANK_CHANNELS    2
+#define PATTERN_BANK_HEADER_SIZE 16
+#define PATTERN_BANK_CHAINED     0x01
+
+struct PatternBankChannel {
+  uint8_t steps;
+  uint8_t fills;
+  uint8_t rotation;
+  uint8_t mode; // a GateSequencerMode
+  uint16_t word;
+};
+
+struct PatternBankEntry {
+  PatternBankChannel channels[PATTERN_BANK_CHANNELS];
+  uint8_t flags;
+  uint8_t reserved[3];
+};
+
+class PatternBank {
+public:
+  PatternBank(const uint8_t* d) : data(d) {}
+
+  /* true if the bytes, of the given size, hold a bank of this version */
+  bool check(size_t size) const {
+    if(size < PATTERN_BANK_HEADER_SIZE ||
+       pgm_read_dword(data) != ('S' | 'B' << 8 | (uint32_t)'N' << 16 | (uint32_t)'K' << 24) ||
+       pgm_read_byte(data + 4) != PATTERN_BANK_VERSION ||
+       pgm_read_byte(data + 5) != PATTERN_BANK_CHANNELS)
+      return false;
+    uint32_t n = getEntries(), w = getWords();
+    if(n > (size - PATTERN_BANK_HEADER_SIZE) / sizeof(PatternBankEntry) ||
+       w > (size - PATTERN_BANK_HEADER_SIZE - n * sizeof(PatternBankEntry)) / sizeof(uint32_t))
+      return false;
+    // every pattern word an entry refers to is in the bank
+    for(uint32_t i=0; i<n; ++i)
+      for(uint8_t c=0; c<PATTERN_BANK_CHANNELS; ++c)
+	if(pgm_read_word(&channel(i, c)->word) >= w)
+	  return false;
+    return true;
+  }
+
+  uint32_t getEntries() const {
+    return pgm_read_dword(data + 8);
+  }
+
+  uint32_t getWords() const {
+    return pgm_read_dword(data + 12);
+  }
+
+  uint8_t getSteps(uint32_t entry, uint8_t c) const {
+    return pgm_read_byte(&channel(entry, c)->steps);
+  }
+
+  uint8_t getFills(uint32_t entry, uint8_t c) const {
+    return pgm_read_byte(&channel(entry, c)->fills);
+  }
+
+  uint8_t getRotation(uint32_t entry, uint8_t c) const {
+    return pgm_read_byte(&channel(entry, c)->rotation);
+  }
+
+  uint8_t getMode(uint32_t entry, uint8_t c) const {
+    return pgm_read_byte(&channel(entry, c)->mode);
+  }
+
+  uint32_t getBits(uint32_t entry, uint8_t c) const {
+    return getWord(pgm_read_word(&channel(entry, c)->word));
+  }
+
+  /* the pattern of a channel turned by its rotation, so that it plays
+     from step 0 as the pattern does rotated; steps must be positive */
+  uint32_t getRotatedBits(uint32_t entry, uint8_t c) const {
+    uint8_t steps = getSteps(entry, c);
+    uint8_t rotation = getRotation(entry, c) % steps;
+    uint32_t bits = getBits(entry, c);
+    if(rotation)
+      bits = bits >> rotation | bits << (steps - rotation);
+    if(steps < 32)
+      bits &= (1UL << steps) - 1;
+    return bits;
+  }
+
+  bool isChained(uint32_t entry) const {
+    return pgm_read_byte(&entries()[entry].flags) & PATTERN_BANK_CHAINED;
+  }
+
+  uint32_t getWord(uint16_t i) const {
+    return pgm_read_dword(words() + i);
+  }
+
+private:
+  inline const PatternBankEntry* entries() const {
+    return (const PatternBankEntry*)(data + PATTERN_BANK_HEADER_SIZE);
+  }
+
+  inline const uint32_t* words() const {
+    return (const uint32_t*)(entries() + getEntries());
+  }
+
+  inline const PatternBankChannel* channel(uint32_t entry, uint8_t c) const {
+    return &entries()[entry].channels[c];
+  }
+
+  const uint8_t* data;
+};
+
+#endif /* _PATTERN_BANK_H_ */
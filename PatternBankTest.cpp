@@ -0,0 +1,176 @@
+/*
+make build/sim/PatternBankTest && ./build/sim/PatternBankTest
+
+Tests the pattern banks of PatternBank.h and lib/PatternBankFile.h, and
+rendering from them.
+*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Test
+#include <boost/test/unit_test.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include "render.h"
+#include "lib/PatternBankFile.h"
+
+const char* lines[] = {
+  "x.mid 16 5 0 t 12 7 3 a 0 120 4",
+  "x.mid 13 4 2 a 9 9 1 t 1 120 4",
+  "x.mid 7 3 5 d 16 5 15 a 1 120 4",
+  "x.mid 16 5 3 t 16 5 0 d 0 120 4",
+};
+const size_t count = sizeof(lines) / sizeof(lines[0]);
+
+/* the gate changes of a render, as (tick, a, b) */
+class CaptureWriter {
+public:
+  void gates(uint32_t tick, const bool* on){
+    events.push_back(tick << 2 | on[0] << 1 | on[1]);
+  }
+  bool close(uint32_t tick){
+    return true;
+  }
+  std::vector<uint32_t> events;
+};
+
+std::vector<uint8_t> buildBank(std::vector<RenderConfig>& configs){
+  PatternBankBuilder builder;
+  for(size_t i=0; i<count; ++i){
+    RenderConfig config;
+    BOOST_REQUIRE(renderParse(lines[i], config));
+    configs.push_back(config);
+    uint32_t bits[RENDER_CHANNELS];
+    BOOST_REQUIRE(builder.add(renderBankEntry(config, bits), bits));
+  }
+  return builder.build();
+}
+
+BOOST_AUTO_TEST_CASE(testLayout){
+  BOOST_CHECK_EQUAL(sizeof(PatternBankChannel), 6);
+  BOOST_CHECK_EQUAL(sizeof(PatternBankEntry), 16);
+  std::vector<RenderConfig> configs;
+  std::vector<uint8_t> data = buildBank(configs);
+  // E(5, 16) is shared by three channels
+  BOOST_CHECK_EQUAL(data.size(), PATTERN_BANK_HEADER_SIZE + count * 16 + 5 * 4);
+  BOOST_CHECK(!memcmp(&data[0], "SBNK", 4));
+  PatternBank bank(&data[0]);
+  BOOST_REQUIRE(bank.check(data.size()));
+  BOOST_CHECK_EQUAL(bank.getEntries(), count);
+  BOOST_CHECK_EQUAL(bank.getWords(), 5);
+  for(size_t i=0; i<count; ++i){
+    for(uint8_t c=0; c<RENDER_CHANNELS; ++c){
+      BOOST_CHECK_EQUAL(bank.getSteps(i, c), configs[i].steps[c]);
+      BOOST_CHECK_EQUAL(bank.getFills(i, c), configs[i].fills[c]);
+      BOOST_CHECK_EQUAL(bank.getRotation(i, c), configs[i].rotation[c]);
+      BOOST_CHECK_EQUAL(bank.getMode(i, c), configs[i].mode[c]);
+      BOOST_CHECK_EQUAL(bank.getBits(i, c), configs[i].bits[c]);
+    }
+    BOOST_CHECK_EQUAL(bank.isChained(i), configs[i].chained);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testCheck){
+  std::vector<RenderConfig> configs;
+  std::vector<uint8_t> data = buildBank(configs);
+  BOOST_CHECK(!PatternBank(&data[0]).check(data.size() - 1));
+  std::vector<uint8_t> bad = data;
+  bad[4] = PATTERN_BANK_VERSION + 1;
+  BOOST_CHECK(!PatternBank(&bad[0]).check(bad.size()));
+  // a word index past the words
+  bad = data;
+  bad[PATTERN_BANK_HEADER_SIZE + 4] = 5;
+  BOOST_CHECK(!PatternBank(&bad[0]).check(bad.size()));
+  PatternBankBuilder empty;
+  std::vector<uint8_t> none = empty.build();
+  BOOST_CHECK(PatternBank(&none[0]).check(none.size()));
+  BOOST_CHECK_EQUAL(PatternBank(&none[0]).getEntries(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(testMappedRenderMatches){
+  std::vector<RenderConfig> configs;
+  std::vector<uint8_t> data = buildBank(configs);
+  char file[] = "/tmp/bankXXXXXX";
+  int fd = mkstemp(file);
+  BOOST_REQUIRE(fd >= 0);
+  ::close(fd);
+  BOOST_REQUIRE(PatternBankBuilder::write(data, file));
+  PatternBankFile in;
+  BOOST_REQUIRE(in.open(file));
+  PatternBank bank = in.getBank();
+  for(size_t i=0; i<count; ++i){
+    RenderConfig config;
+    BOOST_REQUIRE(renderBankEntry(bank, i, config));
+    config.bpm = configs[i].bpm;
+    config.bars = configs[i].bars;
+    CaptureWriter a, b;
+    renderConfig(configs[i], a);
+    renderConfig(config, b);
+    BOOST_CHECK(a.events == b.events);
+  }
+  in.close();
+  BOOST_REQUIRE(!truncate(file, 20));
+  BOOST_CHECK(!in.open(file));
+  unlink(file);
+}
+
+BOOST_AUTO_TEST_CASE(testProgmemHeaderHasTheBytes){
+  std::vector<RenderConfig> configs;
+  std::vector<uint8_t> data = buildBank(configs);
+  FILE* f = tmpfile();
+  BOOST_REQUIRE(f);
+  BOOST_REQUIRE(PatternBankBuilder::writeProgmem(data, f));
+  rewind(f);
+  char line[256];
+  std::vector<uint8_t> bytes;
+  unsigned entries = 0;
+  while(fgets(line, sizeof(line), f)){
+    sscanf(line, "#define PATTERN_BANK_ENTRIES %u", &entries);
+    for(char* p = strstr(line, "0x"); p; p = strstr(p + 2, "0x"))
+      bytes.push_back(strtoul(p, NULL, 16));
+  }
+  fclose(f);
+  BOOST_CHECK_EQUAL(entries, count);
+  BOOST_CHECK(bytes == data);
+}
+
+BOOST_AUTO_TEST_CASE(testRotatedBitsPlayAsRotated){
+  std::vector<RenderConfig> configs;
+  std::vector<uint8_t> data = buildBank(configs);
+  PatternBank bank(&data[0]);
+  for(size_t i=0; i<count; ++i){
+    for(uint8_t c=0; c<RENDER_CHANNELS; ++c){
+      Sequence<uint32_t> rotated, turned;
+      rotated.set(bank.getSteps(i, c), bank.getBits(i, c));
+      rotated.rotate(bank.getRotation(i, c));
+      rotated.reset();
+      turned.set(bank.getSteps(i, c), bank.getRotatedBits(i, c));
+      turned.reset();
+      for(int j=0; j<64; ++j)
+	BOOST_CHECK_EQUAL(rotated.next(), turned.next());
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testModuleBank){
+  std::vector<RenderConfig> configs;
+  std::vector<uint8_t> data = buildBank(configs);
+  uint32_t entry;
+  RenderConfig first;
+  // the second entry needs other mode switches
+  BOOST_CHECK(!renderModuleBank(PatternBank(&data[0]), entry, first));
+  BOOST_CHECK_EQUAL(entry, 1);
+  PatternBankBuilder builder;
+  const char* same[] = { "x.mid 16 5 0 t 12 7 3 a 0 120 4", "x.mid 7 3 5 t 9 4 1 a 0 120 4" };
+  for(size_t i=0; i<2; ++i){
+    RenderConfig config;
+    BOOST_REQUIRE(renderParse(same[i], config));
+    uint32_t bits[RENDER_CHANNELS];
+    BOOST_REQUIRE(builder.add(renderBankEntry(config, bits), bits));
+  }
+  std::vector<uint8_t> playable = builder.build();
+  BOOST_CHECK(renderModuleBank(PatternBank(&playable[0]), entry, first));
+  BOOST_CHECK_EQUAL(first.mode[0], GateSequencer::TRIGGERING);
+  BOOST_CHECK_EQUAL(first.mode[1], GateSequencer::ALTERNATING);
+  BOOST_CHECK(!first.chained);
+  std::vector<uint8_t> none = PatternBankBuilder().build();
+  BOOST_CHECK(!renderModuleBank(PatternBank(&none[0]), entry, first));
+}
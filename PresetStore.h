@@ -0,0 +1,125 @@
+#ifndef _PRESET_STORE_H_
+#define _PRESET_STORE_H_
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <avr/io.h>
+#include <avr/eeprom.h>
+
+/**
+   Wear levelled preset storage in EEPROM.
+   Every save appends a record to a ring that spans the whole EEPROM, so
+   repeatedly saving the same slot spreads the writes over all cells.
+   Records carry a sequence number to find the most recent one, and a
+   CRC so that a record interrupted by a power cut is ignored.
+   Saving is non-blocking: the record is written one byte at a time from
+   the EEPROM ready interrupt, which must call writeNext().
+*/
+
+#define PRESET_EEPROM_SIZE       (E2END+1)
+
+template<typename T>
+class PresetStore {
+public:
+  PresetStore() : head(0), sequence(0), remaining(0) {}
+
+  /* finds the most recent record, call once at startup */
+  void begin(){
+    bool found = false;
+    for(uint8_t i=0; i<RECORDS; ++i){
+      Record r;
+      if(read(i, r) && (!found || (int8_t)(r.sequence - sequence) > 0)){
+	head = i;
+	sequence = r.sequence;
+	found = true;
+      }
+    }
+    if(!found)
+      head = RECORDS-1;
+  }
+
+  /* starts writing a record, returns false if a write is in progress */
+  bool save(uint8_t slot, const T& data){
+    if(remaining)
+      return false;
+    if(++head == RECORDS)
+      head = 0;
+    pending.sequence = ++sequence;
+    pending.slot = slot;
+    pending.data = data;
+    pending.crc = crc((const uint8_t*)&pending, offsetof(Record, crc));
+    address = head * sizeof(Record);
+    remaining = sizeof(Record);
+    EECR |= _BV(EERIE);
+    return true;
+  }
+
+  /* reads the most recent record for the slot, returns false if none */
+  bool recall(uint8_t slot, T& data){
+    if(remaining)
+      return false;
+    uint8_t i = head;
+    for(uint8_t n=0; n<RECORDS; ++n){
+      Record r;
+      if(read(i, r) && r.slot == slot){
+	data = r.data;
+	return true;
+      }
+      i = i ? i-1 : RECORDS-1;
+    }
+    return false;
+  }
+
+  bool isBusy(){
+    return remaining;
+  }
+
+  /* writes the next byte of a pending record, called from EE_READY_vect */
+  void writeNext(){
+    if(remaining){
+      uint8_t offset = sizeof(Record) - remaining--;
+      EEAR = address + offset;
+      EEDR = ((const uint8_t*)&pending)[offset];
+      EECR |= _BV(EEMPE);
+      EECR |= _BV(EEPE);
+    }else{
+      EECR &= ~_BV(EERIE);
+    }
+  }
+
+private:
+  struct Record {
+    uint8_t sequence;
+    uint8_t slot;
+    T data;
+    uint8_t crc;
+  };
+
+  /* at most 127 records, so that sequence numbers compare unambiguously */
+  static const uint8_t RECORDS = PRESET_EEPROM_SIZE/sizeof(Record) > 127 ?
+    127 : PRESET_EEPROM_SIZE/sizeof(Record);
+
+  bool read(uint8_t index, Record& r){
+    eeprom_read_block(&r, (const void*)(uintptr_t)(index * sizeof(Record)), sizeof(Record));
+    return r.crc == crc((const uint8_t*)&r, offsetof(Record, crc));
+  }
+
+  /* CRC-8, polynomial x^8 + x^2 + x + 1 */
+  static uint8_t crc(const uint8_t* data, uint8_t size){
+    uint8_t crc = 0xff;
+    while(size--){
+      crc ^= *data++;
+      for(uint8_t i=0; i<8; ++i)
+	crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+    return crc;
+  }
+
+  Record pending;
+  uint8_t head;
+  uint8_t sequence;
+  uint16_t address;
+  volatile uint8_t remaining;
+};
+
+#endif /* _PRESET_STORE_H_ */
@@ -0,0 +1,144 @@
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+/**
+   Hot path profiling of an instrumented build (SEQUENCER_PROFILE).
+   PROFILE_SCOPE(probe) times the rest of the enclosing block with Timer1,
+   free-running at a prescaler of 8, and keeps the count, minimum, maximum
+   and sum of the times of each probe. Times are wall clock, so those of
+   update() and calculate() include any interrupt handlers that ran
+   meanwhile, and times longer than PROFILE_RANGE_US wrap around.
+
+   Every byte received on the serial port prints the counters, in
+   microseconds, and 'c' also clears them. Without SEQUENCER_PROFILE the
+   probes compile to nothing.
+*/
+
+#define PROFILE_INT0             0
+#define PROFILE_INT1             1
+#define PROFILE_ADC              2
+#define PROFILE_UPDATE           3
+#define PROFILE_CALCULATE        4
+#define PROFILE_PROBES           5
+
+#ifdef SEQUENCER_PROFILE
+
+#ifdef SEQUENCER_INPUT_LOG
+#error The input log and the profiler both use Timer1!
+#endif
+
+#include <inttypes.h>
+#include <avr/io.h>
+#include <util/atomic.h>
+#include "serial.h"
+
+#define PROFILE_PRESCALER        8
+#define PROFILE_TICKS_PER_US     (F_CPU / PROFILE_PRESCALER / 1000000UL)
+#define PROFILE_RANGE_US         (65536UL / PROFILE_TICKS_PER_US)
+
+#define PROFILE_SCOPE(probe)     ProfileScope profileScope(probe)
+
+class Profiler {
+public:
+  Profiler(){
+    clear();
+  }
+
+  /* starts Timer1, call from setup() */
+  void begin(){
+    TCCR1A = 0;
+    TCCR1B = _BV(CS11); // prescaler 8
+    TCNT1 = 0;
+  }
+
+  /* reads the 16-bit timer through the shared TEMP register, so not
+     interruptible by a handler that reads it too */
+  static inline uint16_t now(){
+    uint16_t t;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+      t = TCNT1;
+    }
+    return t;
+  }
+
+  inline void record(uint8_t probe, uint16_t ticks){
+    volatile Probe& p = probes[probe];
+    p.count++;
+    p.sum += ticks;
+    if(ticks < p.min)
+      p.min = ticks;
+    if(ticks > p.max)
+      p.max = ticks;
+  }
+
+  void clear(){
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+      for(uint8_t i=0; i<PROFILE_PROBES; ++i){
+	probes[i].count = 0;
+	probes[i].sum = 0;
+	probes[i].min = 0xffff;
+	probes[i].max = 0;
+      }
+    }
+  }
+
+  /* one line per probe: name, count, then min, mean and max in us */
+  void print(){
+    static const char* const names[PROFILE_PROBES] = {
+      "int0", "int1", "adc", "update", "calculate"
+    };
+    for(uint8_t i=0; i<PROFILE_PROBES; ++i){
+      Probe p;
+      ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+	p.count = probes[i].count;
+	p.sum = probes[i].sum;
+	p.min = probes[i].min;
+	p.max = probes[i].max;
+      }
+      printString(names[i]);
+      printByte(' ');
+      printInteger(p.count);
+      if(p.count){
+	printByte(' ');
+	printInteger(p.min / PROFILE_TICKS_PER_US);
+	printByte('/');
+	printInteger(p.sum / p.count / PROFILE_TICKS_PER_US);
+	printByte('/');
+	printInteger(p.max / PROFILE_TICKS_PER_US);
+      }
+      printNewline();
+    }
+  }
+
+private:
+  struct Probe {
+    uint32_t count;
+    uint32_t sum;
+    uint16_t min;
+    uint16_t max;
+  };
+
+  volatile Probe probes[PROFILE_PROBES];
+};
+
+extern Profiler profiler;
+
+/* times the rest of its block */
+class ProfileScope {
+public:
+  inline ProfileScope(uint8_t p) : probe(p), start(Profiler::now()) {}
+  inline ~ProfileScope(){
+    profiler.record(probe, Profiler::now() - start);
+  }
+private:
+  uint8_t probe;
+  uint16_t start;
+};
+
+#else
+
+#define PROFILE_SCOPE(probe)
+
+#endif /* SEQUENCER_PROFILE */
+
+#endif /* _PROFILE_H_ */
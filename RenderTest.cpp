@@ -0,0 +1,137 @@
+/*
+make build/sim/RenderTest && ./build/sim/RenderTest
+
+Tests the offline renderer of sim/render.h and its thread pool.
+*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Test
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <vector>
+#include "render.h"
+#include "pool.h"
+
+/* the gate changes of a render, as (tick, a, b) */
+class CaptureWriter {
+public:
+  void gates(uint32_t tick, const bool* on){
+    events.push_back(tick << 2 | on[0] << 1 | on[1]);
+  }
+  bool close(uint32_t tick){
+    end = tick;
+    return true;
+  }
+  std::vector<uint32_t> events;
+  uint32_t end;
+};
+
+RenderConfig parse(const char* line){
+  RenderConfig config;
+  BOOST_REQUIRE_MESSAGE(renderParse(line, config), line);
+  return config;
+}
+
+BOOST_AUTO_TEST_CASE(testParse){
+  RenderConfig config = parse("out.mid 16 5 3 t 7 2 0 a 1 132.5 8");
+  BOOST_CHECK_EQUAL(config.output, "out.mid");
+  BOOST_CHECK_EQUAL(config.steps[1], 7);
+  BOOST_CHECK_EQUAL(config.rotation[0], 3);
+  BOOST_CHECK_EQUAL(config.mode[1], GateSequencer::ALTERNATING);
+  BOOST_CHECK(config.chained);
+  BOOST_CHECK_EQUAL(config.bars, 8);
+  BOOST_CHECK(!renderParse("out.mid 17 5 3 t 7 2 0 a 1 120 8", config));
+  BOOST_CHECK(!renderParse("out.mid 16 5 16 t 7 2 0 a 1 120 8", config));
+  BOOST_CHECK(!renderParse("out.mid 16 5 3 x 7 2 0 a 1 120 8", config));
+  BOOST_CHECK(!renderParse("out.mid 16 5 3 t 7 8 0 a 1 120 8", config));
+  BOOST_CHECK(!renderParse("out.mid 16 5 3 t 7 2 0 a 1 120", config));
+}
+
+BOOST_AUTO_TEST_CASE(testTriggeringFollowsPattern){
+  RenderConfig config = parse("x.csv 8 3 1 t 1 0 0 d 0 120 1");
+  CaptureWriter writer;
+  BOOST_REQUIRE(renderConfig(config, writer));
+  BOOST_CHECK_EQUAL(writer.end, RENDER_STEPS_PER_BAR * RENDER_TICKS_PER_STEP);
+  Sequence<SEQUENCER_BITS_TYPE> seq;
+  seq.calculate(8, 3);
+  seq.rotate(1);
+  seq.reset();
+  std::vector<uint32_t> expected;
+  for(uint32_t step=0; step<RENDER_STEPS_PER_BAR; ++step){
+    if(seq.next()){
+      expected.push_back((step * RENDER_TICKS_PER_STEP) << 2 | 2);
+      expected.push_back((step * RENDER_TICKS_PER_STEP + RENDER_TICKS_PER_STEP / 2) << 2);
+    }
+  }
+  BOOST_CHECK_EQUAL_COLLECTIONS(writer.events.begin(), writer.events.end(),
+				expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(testChainedPlaysAThenB){
+  // A has all fills and B none, so the gates show which one plays
+  RenderConfig config = parse("x.csv 3 3 0 t 5 0 0 t 1 120 1");
+  CaptureWriter writer;
+  BOOST_REQUIRE(renderConfig(config, writer));
+  std::vector<uint32_t> expected;
+  for(uint32_t step=0; step<RENDER_STEPS_PER_BAR; ++step){
+    if(step % 8 < 3){
+      expected.push_back((step * RENDER_TICKS_PER_STEP) << 2 | 3);
+      expected.push_back((step * RENDER_TICKS_PER_STEP + RENDER_TICKS_PER_STEP / 2) << 2);
+    }
+  }
+  BOOST_CHECK_EQUAL_COLLECTIONS(writer.events.begin(), writer.events.end(),
+				expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(testMidiTrackLength){
+  FILE* f = tmpfile();
+  BOOST_REQUIRE(f);
+  {
+    MidiGateWriter writer(f, 120);
+    BOOST_REQUIRE(renderConfig(parse("x.mid 16 5 0 t 12 7 3 a 0 120 4"), writer));
+  }
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  uint8_t header[22];
+  rewind(f);
+  BOOST_REQUIRE_EQUAL(fread(header, 1, sizeof(header), f), sizeof(header));
+  fclose(f);
+  BOOST_CHECK(!memcmp(header, "MThd", 4));
+  BOOST_CHECK(!memcmp(header + 14, "MTrk", 4));
+  long length = (long)header[18] << 24 | header[19] << 16 | header[20] << 8 | header[21];
+  BOOST_CHECK_EQUAL(length, size - 22);
+}
+
+BOOST_AUTO_TEST_CASE(testPoolRunsEveryJobOnce){
+  const size_t jobs = 1000;
+  std::vector<std::atomic<int> > runs(jobs);
+  WorkStealingPool pool(8);
+  pool.run(jobs, [&](size_t i){
+      // uneven jobs, the first ones long
+      volatile unsigned spin = 0;
+      for(unsigned k=0; k<(jobs - i) * 100; ++k)
+	spin++;
+      runs[i]++;
+    });
+  for(size_t i=0; i<jobs; ++i)
+    BOOST_REQUIRE_EQUAL(runs[i], 1);
+}
+
+BOOST_AUTO_TEST_CASE(testThreadsRenderAlike){
+  const char* lines[] = {
+    "x.csv 16 5 0 t 12 7 3 a 0 120 4",
+    "x.csv 13 4 2 a 9 9 1 t 1 120 4",
+    "x.csv 7 3 5 d 16 11 15 a 1 120 4",
+  };
+  std::vector<RenderConfig> configs;
+  std::vector<CaptureWriter> single(3), parallel(3 * 16);
+  for(size_t i=0; i<3; ++i){
+    configs.push_back(parse(lines[i]));
+    renderConfig(configs[i], single[i]);
+  }
+  WorkStealingPool pool(8);
+  pool.run(parallel.size(), [&](size_t i){
+      renderConfig(configs[i % 3], parallel[i]);
+    });
+  for(size_t i=0; i<parallel.size(); ++i)
+    BOOST_REQUIRE(parallel[i].events == single[i % 3].events);
+}
@@ -0,0 +1,91 @@
+/*
+make build/sim/RhythmBankTest && ./build/sim/RhythmBankTest
+
+Tests that a build with SEQUENCER_PATTERN_BANK loads each entry of a bank
+into GateSequencer as render plays it, for every rotation of every
+Euclidean rhythm of up to 16 steps.
+*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Test
+#include <boost/test/unit_test.hpp>
+#include <stdio.h>
+#include <vector>
+#define SEQUENCER_RHYTHM_CATALOGUE
+#define SEQUENCER_PATTERN_BANK
+// the bank of each case, instead of bank.h
+#define PATTERN_BANK_ENTRIES 256
+const uint8_t* patternBank;
+#include "render.h"
+#include "lib/PatternBankFile.h"
+
+/* the gate changes of a render, as (tick, a, b) */
+class CaptureWriter {
+public:
+  void gates(uint32_t tick, const bool* on){
+    events.push_back(tick << 2 | on[0] << 1 | on[1]);
+  }
+  bool close(uint32_t tick){
+    return true;
+  }
+  std::vector<uint32_t> events;
+};
+
+/* the configuration the module plays with the fill knob at value */
+RenderConfig loaded(const RenderConfig& config, uint32_t entry, uint16_t value){
+  sim_reset();
+  GateSequencer seqA(SEQUENCER_OUTPUT_PIN_A, SEQUENCER_TRIGGER_SWITCH_PIN_A,
+		     SEQUENCER_ALTERNATE_SWITCH_PIN_A, SEQUENCER_LED_A_PIN);
+  GateSequencer seqB(SEQUENCER_OUTPUT_PIN_B, SEQUENCER_TRIGGER_SWITCH_PIN_B,
+		     SEQUENCER_ALTERNATE_SWITCH_PIN_B, SEQUENCER_LED_B_PIN);
+  GateSequencer* channels[RENDER_CHANNELS] = { &seqA, &seqB };
+  RenderConfig played = config;
+  for(uint8_t c=0; c<RENDER_CHANNELS; ++c){
+    channels[c]->load(entry, value);
+    played.steps[c] = channels[c]->length;
+    played.bits[c] = channels[c]->bits;
+    played.rotation[c] = 0;
+  }
+  return played;
+}
+
+BOOST_AUTO_TEST_CASE(testEntriesPlayAsRendered){
+  for(unsigned n=1; n<=16; ++n){
+    for(unsigned k=0; k<=n; ++k){
+      // an entry per rotation, turned one step further on B
+      std::vector<RenderConfig> configs;
+      PatternBankBuilder builder;
+      for(unsigned r=0; r<n; ++r){
+	char line[64];
+	snprintf(line, sizeof(line), "x.csv %u %u %u t %u %u %u a 0 120 2", n, k, r, n, k, (r + 1) % n);
+	RenderConfig config;
+	BOOST_REQUIRE(renderParse(line, config));
+	uint32_t bits[RENDER_CHANNELS];
+	BOOST_REQUIRE(builder.add(renderBankEntry(config, bits), bits));
+	configs.push_back(config);
+      }
+      std::vector<uint8_t> data = builder.build();
+      patternBank = &data[0];
+      for(uint32_t i=0; i<configs.size(); ++i){
+	CaptureWriter expected, actual;
+	renderConfig(configs[i], expected);
+	renderConfig(loaded(configs[i], i, 0), actual);
+	BOOST_CHECK_MESSAGE(expected.events == actual.events,
+			    "E(" << k << "," << n << ") rotated by " << i);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testFillKnobSelectsOnsets){
+  // E(3,8) starts on a gap: . x . . x . . x
+  PatternBankBuilder builder;
+  RenderConfig config;
+  BOOST_REQUIRE(renderParse("x.csv 8 3 0 t 8 3 0 t 0 120 2", config));
+  uint32_t bits[RENDER_CHANNELS];
+  BOOST_REQUIRE(builder.add(renderBankEntry(config, bits), bits));
+  std::vector<uint8_t> data = builder.build();
+  patternBank = &data[0];
+  BOOST_CHECK_EQUAL(loaded(config, 0, 0).bits[0], 0x92);
+  BOOST_CHECK_EQUAL(loaded(config, 0, ADC_VALUE_RANGE/2).bits[0], 0x29);
+  BOOST_CHECK_EQUAL(loaded(config, 0, ADC_VALUE_RANGE-1).bits[0], 0x25);
+}
@@ -0,0 +1,95 @@
+#ifndef _RHYTHM_CATALOGUE_H_
+#define _RHYTHM_CATALOGUE_H_
+
+#include <inttypes.h>
+#include <avr/pgmspace.h>
+
+/**
+   Catalogue of named Euclidean rhythms, stored in program memory.
+   The table is generated from patterns.txt by rhythms.py and is sorted by
+   number of steps, so only the entries that fit the sequencer are used.
+   The step knob selects a rhythm and the fill knob the onset it starts
+   on, see getRhythmOnset(); at the minimum of the fill knob it plays as
+   it is stored.
+   With SEQUENCER_PATTERN_BANK the catalogue is instead the bank flashed
+   from bank.h (see PatternBank.h), up to 256 entries: the step knob of
+   each channel selects an entry, and the channel plays its own steps and
+   pattern of it, turned by its rotation. The switches of the module, not
+   the bank, set the modes and chaining; sim/bank only writes bank.h for
+   banks that the switches can play.
+*/
+
+struct Rhythm {
+  uint8_t steps;
+  uint8_t fills;
+  uint32_t bits;
+};
+
+#ifdef SEQUENCER_PATTERN_BANK
+#include "PatternBank.h"
+#ifndef PATTERN_BANK_ENTRIES // unless a test provides its own bank
+#include "bank.h"
+#endif
+
+#if PATTERN_BANK_ENTRIES > 256
+#define RHYTHM_CATALOGUE_ENTRIES 256
+#else
+#define RHYTHM_CATALOGUE_ENTRIES PATTERN_BANK_ENTRIES
+#endif
+
+inline uint8_t getRhythmSteps(uint8_t index, uint8_t channel){
+  return PatternBank(patternBank).getSteps(index, channel);
+}
+
+/* turned by the rotation of the entry, which the rotation knob then
+   turns further */
+inline uint32_t getRhythmBits(uint8_t index, uint8_t channel){
+  return PatternBank(patternBank).getRotatedBits(index, channel);
+}
+
+#else /* SEQUENCER_PATTERN_BANK */
+#include "rhythms.h"
+
+#if SEQUENCER_STEPS_RANGE >= 32
+#define RHYTHM_CATALOGUE_ENTRIES RHYTHM_CATALOGUE_SIZE
+#else
+#define RHYTHM_CATALOGUE_ENTRIES RHYTHM_CATALOGUE_SIZE_16
+#endif
+
+/* the catalogue is the same for both channels */
+inline uint8_t getRhythmSteps(uint8_t index, uint8_t channel){
+  return pgm_read_byte(&rhythms[index].steps);
+}
+
+inline uint32_t getRhythmBits(uint8_t index, uint8_t channel){
+  return pgm_read_dword(&rhythms[index].bits);
+}
+#endif /* SEQUENCER_PATTERN_BANK */
+
+/* the pattern started on its pulse number onset, counting from 0, so
+   that it plays from there after a reset. Onset 0 is the pattern as it
+   is, which keeps the rotation of a bank entry that starts on a gap */
+inline uint32_t getRhythmOnset(uint32_t bits, uint8_t steps, uint8_t onset){
+  if(!onset)
+    return bits;
+  uint8_t start = 0;
+  for(; start < steps; ++start)
+    if(((bits >> start) & 1) && !onset--)
+      break;
+  if(!start || start == steps)
+    return bits;
+  bits = bits >> start | bits << (steps - start);
+  if(steps < 32)
+    bits &= (1UL << steps) - 1;
+  return bits;
+}
+
+/* the number of pulses of a pattern */
+inline uint8_t getRhythmOnsets(uint32_t bits){
+  uint8_t n = 0;
+  for(; bits; bits &= bits - 1)
+    n++;
+  return n;
+}
+
+#endif /* _RHYTHM_CATALOGUE_H_ */
@@ -0,0 +1,36 @@
+/*
+make build/sim/RhythmCatalogueTest && ./build/sim/RhythmCatalogueTest
+
+Tests the rhythms of the catalogue in RhythmCatalogue.h, and starting
+them on each of their onsets.
+*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Test
+#include <boost/test/unit_test.hpp>
+#include "Sequence.h"
+#include "RhythmCatalogue.h"
+
+typedef Sequence<uint32_t> Sequence32;
+
+BOOST_AUTO_TEST_CASE(testRhythmOnsets){
+  for(uint8_t i=0; i<RHYTHM_CATALOGUE_SIZE; ++i){
+    uint8_t steps = getRhythmSteps(i, 0);
+    uint32_t bits = getRhythmBits(i, 0);
+    uint8_t onsets = getRhythmOnsets(bits);
+    BOOST_CHECK_EQUAL(onsets, pgm_read_byte(&rhythms[i].fills));
+    BOOST_CHECK_EQUAL(getRhythmOnset(bits, steps, 0), bits);
+    Sequence32 rhythm;
+    rhythm.set(steps, bits);
+    uint8_t onset = 0;
+    for(uint8_t step=0; step<steps; ++step){
+      if(!rhythm.peek(step))
+	continue;
+      // a pulse of the rhythm, which started on it plays it from step 0
+      Sequence32 started;
+      started.set(steps, getRhythmOnset(bits, steps, onset++));
+      for(uint8_t j=0; j<steps; ++j)
+	BOOST_CHECK_EQUAL(started.peek(j), rhythm.peek(step + j));
+    }
+    BOOST_CHECK_EQUAL(getRhythmOnset(bits, steps, onsets), bits);
+  }
+}
@@ -0,0 +1,103 @@
+/*
+make build/sim/RhythmIteratorTest && ./build/sim/RhythmIteratorTest
+
+Tests the lazy rhythms of lib/RhythmIterator.h against Sequence, and
+their skip-ahead against stepping on long cycles.
+*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Test
+#include <boost/test/unit_test.hpp>
+#include <stdlib.h>
+#include "Sequence.h"
+#include "lib/RhythmIterator.h"
+
+typedef Sequence<uint64_t> Sequence64;
+
+BOOST_AUTO_TEST_CASE(testMatchesSequence){
+  for(uint8_t n=1; n<=64; ++n){
+    for(uint8_t k=0; k<=n; ++k){
+      EuclideanRhythm rhythm(n, k);
+      RhythmIterator it(rhythm);
+      Sequence64 seq;
+      seq.calculate(n, k);
+      seq.reset();
+      for(uint8_t i=0; i<n; ++i)
+	BOOST_REQUIRE_MESSAGE(rhythm.at(i) == (bool)((seq.bits >> i) & 1),
+			      "E(" << (int)k << ", " << (int)n << ") step " << (int)i);
+      for(int i=0; i<3*n; ++i){
+	if(i == n)
+	  seq.rotate(k % 16), it.rotate(k % 16);
+	if(i == 2*n)
+	  seq.seek(k * 7), it.seek(k * 7);
+	BOOST_REQUIRE_EQUAL(it.peek(i), seq.peek(i));
+	BOOST_REQUIRE_EQUAL(it.getPosition(), seq.pos);
+	BOOST_REQUIRE_EQUAL(it.next(), seq.next());
+	BOOST_REQUIRE_EQUAL(it.getStep(), seq.getStep());
+      }
+      seq.reset();
+      it.reset();
+      BOOST_REQUIRE_EQUAL(it.getPosition(), seq.pos);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testLongCycles){
+  srand(1);
+  for(int t=0; t<20; ++t){
+    uint64_t n = 1 + (((uint64_t)rand() << 16) ^ rand()) % 3000000;
+    uint64_t k = ((uint64_t)rand() << 16 ^ rand()) % (n + 1);
+    EuclideanRhythm rhythm(n, k);
+    RhythmIterator it(rhythm);
+    uint64_t pulses = 0;
+    for(uint64_t i=0; i<n; ++i){
+      if(i % 9973 == 0){
+	BOOST_REQUIRE_EQUAL(rhythm.rank(i), pulses);
+	BOOST_REQUIRE_EQUAL(it.getPosition(), i);
+      }
+      bool pulse = it.next();
+      if(i % 1013 == 0)
+	BOOST_REQUIRE_EQUAL(rhythm.at(i), pulse);
+      if(pulse){
+	if(pulses % 101 == 0)
+	  BOOST_REQUIRE_EQUAL(rhythm.select(pulses), i);
+	pulses++;
+      }
+    }
+    BOOST_REQUIRE_EQUAL(pulses, k);
+    BOOST_REQUIRE_EQUAL(it.getCycle(), 1);
+    // skipping lands where stepping does
+    RhythmIterator a(rhythm), b(rhythm);
+    a.rotate(n / 3);
+    b.rotate(n / 3);
+    uint64_t skip = n / 7 + 5;
+    a.skip(skip);
+    for(uint64_t i=0; i<skip; ++i)
+      b.next();
+    BOOST_REQUIRE_EQUAL(a.getPosition(), b.getPosition());
+    for(int i=0; i<1000; ++i)
+      BOOST_REQUIRE_EQUAL(a.next(), b.next());
+    // and on the next pulse
+    uint64_t until = a.untilPulse();
+    if(k){
+      a.skip(until);
+      BOOST_REQUIRE(rhythm.at(a.getPosition()));
+      for(uint64_t i=0; i<until; ++i)
+	BOOST_REQUIRE(!b.next());
+    }else{
+      BOOST_REQUIRE_EQUAL(until, n);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testHugeSkip){
+  // 2^62 steps: skip and peek without stepping through
+  uint64_t n = 1ULL << 62;
+  EuclideanRhythm rhythm(n, n / 3 + 1);
+  RhythmIterator it(rhythm);
+  it.skip(n - 1);
+  BOOST_REQUIRE_EQUAL(it.getPosition(), n - 1);
+  bool last = it.next();
+  BOOST_CHECK_EQUAL(last, rhythm.at(n - 1));
+  BOOST_CHECK_EQUAL(it.getPosition(), 0);
+  BOOST_CHECK_EQUAL(rhythm.rank(n - 1) + last, n / 3 + 1);
+}
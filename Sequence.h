@@ -2,7 +2,9 @@
 #define _SEQUENCE_H_
 
 #include <inttypes.h>
+#include <util/atomic.h>
 #include "bjorklund.h"
+#include "Profile.h"
 
 #ifdef SERIAL_DEBUG
 #include "serial.h"
@@ -10,17 +12,37 @@
 
 #define SEQUENCE_ALGORITHM_ARRAY_SIZE 10
 
-template<typename T>
+/* a point where the clock or reset interrupt may preempt the main loop,
+   the fuzz harness defines it to run the interrupt handlers there */
+#ifndef SEQUENCER_YIELD
+#define SEQUENCER_YIELD()
+#endif
+
+/* Algorithm computes the pattern, with the interface of Bjorklund */
+template<typename T, class Algorithm = Bjorklund<T, SEQUENCE_ALGORITHM_ARRAY_SIZE> >
 class Sequence {
 public:
- Sequence() : pos(0), length(1) {}
+ Sequence() : length(1), offset(0), pos(0), counter(0) {}
 
   void calculate(uint8_t steps, uint8_t fills){
-    Bjorklund<T, SEQUENCE_ALGORITHM_ARRAY_SIZE> algo;
+    PROFILE_SCOPE(PROFILE_CALCULATE);
+    Algorithm algo;
     T newbits;
     newbits = algo.compute(steps, fills);
-    length = steps;
-    bits = newbits;
+    SEQUENCER_YIELD();
+    set(steps, newbits);
+  }
+
+  /* replaces the pattern, atomically so that the clock interrupt never
+     plays the new length with the old bits, or a half written word */
+  void set(uint8_t steps, T newbits){
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+      length = steps;
+      SEQUENCER_YIELD();
+      bits = newbits;
+      if(pos >= length)
+	pos = 0;
+    }
   }
 
 #ifdef SERIAL_DEBUG
@@ -34,17 +56,56 @@ public:
 
   void reset(){
     pos = offset % length;
+    counter = 0;
+  }
+
+  /* move to absolute step index, eg from a song position pointer */
+  void seek(uint16_t step){
+    pos = (step + offset) % length;
+    counter = step;
+  }
+
+  /* value at absolute step index, without changing position */
+  bool peek(uint16_t step) const {
+    return bits & (1UL << ((step + offset) % length));
+  }
+
+  /* absolute number of steps played since last reset or seek, modulo
+     65536: the counter wraps to 0 after 65536 steps */
+  uint16_t getStep() const {
+    return counter;
+  }
+
+  /* absolute number of full cycles played since last reset or seek,
+     counted from getStep(), so it also restarts from 0 when the step
+     counter wraps, at a cycle boundary only if the length is a power
+     of two */
+  uint16_t getCycle() const {
+    return counter / length;
   }
 
   void rotate(int8_t steps){
-    pos = (length + pos + steps - offset) % length;
-    offset = steps;
+    // the clock interrupt must not advance pos while it is being moved
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+      pos = (length + pos + steps - offset % length) % length;
+      SEQUENCER_YIELD();
+      offset = steps;
+    }
+  }
+
+  /* moves on a step, as next() does, without reading it */
+  void skip(){
+    if(++pos >= length)
+      pos = 0;
+    counter++;
   }
 
   bool next(){
-    if(pos >= length)
+    bool bit = bits & (1UL << pos);
+    if(++pos >= length)
       pos = 0;
-    return bits & (1UL << pos++);
+    counter++;
+    return bit;
   }
 
 // private:
@@ -52,6 +113,7 @@ public:
   uint8_t length;
   int8_t offset;
   volatile uint8_t pos;
+  volatile uint16_t counter;
 };
 
 #endif /* _SEQUENCE_H_ */
@@ -0,0 +1,87 @@
+/*
+make enginebench BENCHARGS="-j engine.json"
+
+Benchmarks a clock period (rise and fall) of the multi-instance engine
+with each kernel, against as many GateSequence objects, on one core, and
+prints the sequencers stepped per second.
+usage: SequenceEngineBenchmark [-j file.json] [name filter]
+*/
+
+#include <stdlib.h>
+#include "benchmark.h"
+#include "GateSequence.h"
+#include "lib/SequenceEngine.h"
+
+typedef FlagGateSequence<uint32_t> BenchmarkSequencer;
+
+static const char* kernelNames[] = { "auto", "scalar", "sse2", "avx2" };
+
+std::string name(const char* prefix, const char* kernel, size_t count){
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%s/%s/%zu", prefix, kernel, count);
+  return buf;
+}
+
+int main(int argc, char** argv){
+  const char* json = NULL;
+  std::string filter;
+  for(int i=1; i<argc; ++i){
+    if(!strcmp(argv[i], "-j") && i+1 < argc)
+      json = argv[++i];
+    else
+      filter = argv[i];
+  }
+  Benchmark bench;
+  std::vector<size_t> counts;
+#define BENCHMARK(title, instances, body)				\
+  if(std::string(title).find(filter) != std::string::npos){		\
+    bench.run(title, [&](uint64_t n){ for(uint64_t i=0; i<n; ++i){ body; } }); \
+    counts.push_back(instances);					\
+  }
+
+  static const size_t sizes[] = { 1024, 16384, 65536 };
+  for(size_t count : sizes){
+    std::vector<BenchmarkSequencer> objects(count);
+    SequenceEngine engine(count);
+    for(size_t i=0; i<count; ++i){
+      uint8_t steps = 1 + rand() % SEQUENCE_ENGINE_MAX_STEPS;
+      uint8_t fills = rand() % (steps + 1);
+      uint8_t offset = rand() % steps;
+      int mode = rand() % 3;
+      objects[i].calculate(steps, fills);
+      objects[i].rotate(offset);
+      objects[i].setMode((BenchmarkSequencer::GateSequencerMode)mode);
+      engine.calculate(i, steps, fills);
+      engine.rotate(i, offset);
+      engine.setMode(i, (SequenceEngine::Mode)mode);
+    }
+    BENCHMARK(name("objects", "scalar", count), count,
+	      for(size_t j=0; j<count; ++j) objects[j].rise();
+	      for(size_t j=0; j<count; ++j) objects[j].fall();
+	      benchmarkKeep(objects[i % count].gate));
+    for(int k=SequenceEngine::SCALAR; k<=SequenceEngine::AVX2; ++k){
+      if(!SequenceEngine::supported((SequenceEngine::Kernel)k))
+	continue;
+      SequenceEngine copy = engine;
+      copy.setKernel((SequenceEngine::Kernel)k);
+      BENCHMARK(name("engine", kernelNames[k], count), count,
+		copy.rise(); copy.fall(); benchmarkKeep(copy.getGates()[0]));
+    }
+  }
+
+  printf("\n%-40s %16s\n", "", "sequencers/s");
+  const std::vector<BenchmarkResult>& results = bench.getResults();
+  for(size_t i=0; i<results.size(); ++i)
+    printf("%-40s %16.0f\n", results[i].name.c_str(), counts[i] * 1e9 / results[i].median);
+
+  if(json){
+    FILE* out = fopen(json, "w");
+    if(!out){
+      perror(json);
+      return 1;
+    }
+    bench.writeJson(out);
+    fclose(out);
+  }
+  return 0;
+}
@@ -0,0 +1,95 @@
+/*
+make build/sim/SequenceEngineTest && ./build/sim/SequenceEngineTest
+
+Tests each kernel of the multi-instance engine against GateSequence.
+*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Test
+#include <boost/test/unit_test.hpp>
+#include <stdlib.h>
+#include <vector>
+#include "GateSequence.h"
+#include "lib/SequenceEngine.h"
+
+typedef FlagGateSequence<uint32_t> ReferenceSequencer;
+
+static const SequenceEngine::Kernel kernels[] = {
+  SequenceEngine::SCALAR, SequenceEngine::SSE2, SequenceEngine::AVX2
+};
+
+/* a random pattern, rotation or mode for a random sequencer of both */
+void change(SequenceEngine& engine, std::vector<ReferenceSequencer>& ref){
+  size_t i = rand() % ref.size();
+  switch(rand() % 3){
+  case 0: {
+    uint8_t steps = 1 + rand() % SEQUENCE_ENGINE_MAX_STEPS;
+    uint8_t fills = rand() % (steps + 1);
+    engine.calculate(i, steps, fills);
+    ref[i].calculate(steps, fills);
+    break;
+  }
+  case 1: {
+    int8_t offset = rand() % 128;
+    engine.rotate(i, offset);
+    ref[i].rotate(offset);
+    break;
+  }
+  case 2: {
+    int mode = rand() % 3;
+    engine.setMode(i, (SequenceEngine::Mode)mode);
+    ref[i].setMode((ReferenceSequencer::GateSequencerMode)mode);
+    break;
+  }
+  }
+}
+
+void check(const SequenceEngine& engine, const std::vector<ReferenceSequencer>& ref, int tick){
+  for(size_t i=0; i<ref.size(); ++i){
+    BOOST_REQUIRE_MESSAGE(engine.gate(i) == ref[i].gate,
+			  "kernel " << engine.getKernel() << " sequencer " << i << " tick " << tick);
+    BOOST_REQUIRE_EQUAL(engine.position(i), ref[i].pos);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testKernelsMatchGateSequence){
+  for(SequenceEngine::Kernel k : kernels){
+    if(!SequenceEngine::supported(k)){
+      BOOST_TEST_MESSAGE("kernel " << k << " not supported, skipped");
+      continue;
+    }
+    srand(k);
+    // not a whole number of bitmap words
+    SequenceEngine engine(1000, k);
+    BOOST_REQUIRE_EQUAL(engine.getKernel(), k);
+    std::vector<ReferenceSequencer> ref(engine.size());
+    for(int i=0; i<4000; ++i)
+      change(engine, ref);
+    for(int tick=0; tick<500; ++tick){
+      for(int i=0; i<20; ++i)
+	change(engine, ref);
+      if(tick % 97 == 0){
+	engine.reset();
+	for(size_t i=0; i<ref.size(); ++i)
+	  ref[i].reset();
+      }
+      engine.rise();
+      for(size_t i=0; i<ref.size(); ++i)
+	ref[i].rise();
+      check(engine, ref, tick);
+      engine.fall();
+      for(size_t i=0; i<ref.size(); ++i)
+	ref[i].fall();
+      check(engine, ref, tick);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testPaddingStaysOff){
+  SequenceEngine engine(3);
+  for(size_t i=0; i<engine.size(); ++i){
+    engine.calculate(i, 1, 1);
+    engine.setMode(i, SequenceEngine::TRIGGERING);
+  }
+  engine.rise();
+  BOOST_CHECK_EQUAL(engine.getGates()[0], 7);
+}
@@ -0,0 +1,84 @@
+/*
+make processbench BENCHARGS="-j process.json"
+
+Benchmarks the block processing of SequenceProcessor at 48 and 96 kHz,
+with a clock of sixteenth notes at 120 bpm, and prints how many times
+faster than real time each configuration runs on one core.
+usage: SequenceProcessorBenchmark [-j file.json] [name filter]
+*/
+
+#include <stdlib.h>
+#include "benchmark.h"
+#include "lib/SequenceProcessor.h"
+
+#define BLOCK_SIZE               256
+#define CLOCK_HZ                 8
+
+std::string name(unsigned rate, size_t count){
+  char buf[64];
+  snprintf(buf, sizeof(buf), "process/%u/%zu/%d", rate, count, BLOCK_SIZE);
+  return buf;
+}
+
+int main(int argc, char** argv){
+  const char* json = NULL;
+  std::string filter;
+  for(int i=1; i<argc; ++i){
+    if(!strcmp(argv[i], "-j") && i+1 < argc)
+      json = argv[++i];
+    else
+      filter = argv[i];
+  }
+  Benchmark bench;
+  std::vector<double> seconds;
+
+  static const unsigned rates[] = { 48000, 96000 };
+  static const size_t counts[] = { 1024, 4096, 16384 };
+  for(unsigned rate : rates){
+    // a whole number of blocks of the clock, so that each block is alike
+    size_t period = rate / CLOCK_HZ;
+    size_t blocks = (period + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    std::vector<float> clock(blocks * BLOCK_SIZE);
+    for(size_t s=0; s<clock.size(); ++s)
+      clock[s] = (s % period) < period / 2 ? 1.0f : 0.0f;
+    std::vector<float> reset(BLOCK_SIZE, 0.0f);
+    for(size_t count : counts){
+      std::string title = name(rate, count);
+      if(title.find(filter) == std::string::npos)
+	continue;
+      SequenceProcessor processor(count);
+      for(size_t i=0; i<count; ++i){
+	uint8_t steps = 1 + rand() % SEQUENCE_ENGINE_MAX_STEPS;
+	processor.calculate(i, steps, rand() % (steps + 1));
+	processor.rotate(i, rand() % steps);
+	processor.setMode(i, (SequenceEngine::Mode)(rand() % 3));
+      }
+      std::vector<float> gates(count * BLOCK_SIZE);
+      std::vector<float*> out(count);
+      for(size_t i=0; i<count; ++i)
+	out[i] = &gates[i * BLOCK_SIZE];
+      bench.run(title, [&](uint64_t n){
+	  for(uint64_t i=0; i<n; ++i)
+	    processor.process(&clock[(i % blocks) * BLOCK_SIZE], &reset[0], &out[0], BLOCK_SIZE);
+	  benchmarkKeep(gates[0]);
+	});
+      seconds.push_back((double)BLOCK_SIZE / rate);
+    }
+  }
+
+  printf("\n%-40s %16s\n", "", "x real time");
+  const std::vector<BenchmarkResult>& results = bench.getResults();
+  for(size_t i=0; i<results.size(); ++i)
+    printf("%-40s %16.1f\n", results[i].name.c_str(), seconds[i] * 1e9 / results[i].median);
+
+  if(json){
+    FILE* out = fopen(json, "w");
+    if(!out){
+      perror(json);
+      return 1;
+    }
+    bench.writeJson(out);
+    fclose(out);
+  }
+  return 0;
+}
@@ -0,0 +1,112 @@
+/*
+make build/sim/SequenceProcessorTest && ./build/sim/SequenceProcessorTest
+
+Tests the block processing of SequenceProcessor against GateSequence
+stepped sample by sample, with the reset held as in the firmware.
+*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Test
+#include <boost/test/unit_test.hpp>
+#include <stdlib.h>
+#include <vector>
+#include "GateSequence.h"
+#include "lib/SequenceProcessor.h"
+
+typedef FlagGateSequence<uint32_t> ReferenceSequencer;
+
+/* the firmware interrupt handlers, a sample at a time */
+class ReferenceProcessor {
+public:
+  ReferenceProcessor(size_t count) : seqs(count), clock(false), reset(false), pending(false) {}
+
+  void sample(bool clockIn, bool resetIn){
+    if(resetIn != reset){
+      reset = resetIn;
+      if(reset)
+	for(size_t i=0; i<seqs.size(); ++i)
+	  seqs[i].reset();
+    }
+    if(clockIn != clock){
+      clock = clockIn;
+      pending = true;
+    }
+    if(pending && !reset){
+      pending = false;
+      for(size_t i=0; i<seqs.size(); ++i)
+	clock ? seqs[i].rise() : seqs[i].fall();
+    }
+  }
+
+  std::vector<ReferenceSequencer> seqs;
+  bool clock, reset, pending;
+};
+
+/* a square wave with random run lengths, and values close to the threshold */
+std::vector<float> randomSignal(size_t n, int run){
+  std::vector<float> signal(n);
+  bool high = false;
+  for(size_t s=0; s<n; ){
+    for(int len = 1 + rand() % run; len && s<n; --len)
+      signal[s++] = high ? 0.5f + (rand() % 5) * 0.25f : 0.5f - (rand() % 3) * 0.25f;
+    high = !high;
+  }
+  return signal;
+}
+
+BOOST_AUTO_TEST_CASE(testBlocksMatchReference){
+  static const SequenceEngine::Kernel kernels[] = {
+    SequenceEngine::SCALAR, SequenceEngine::SSE2, SequenceEngine::AVX2
+  };
+  for(SequenceEngine::Kernel k : kernels){
+    if(!SequenceEngine::supported(k))
+      continue;
+    srand(k);
+    const size_t count = 77, n = 20000;
+    SequenceProcessor processor(count, k);
+    ReferenceProcessor reference(count);
+    for(size_t i=0; i<count; ++i){
+      uint8_t steps = 1 + rand() % SEQUENCE_ENGINE_MAX_STEPS;
+      uint8_t fills = rand() % (steps + 1);
+      uint8_t offset = rand() % 128;
+      int mode = rand() % 3;
+      processor.calculate(i, steps, fills);
+      processor.rotate(i, offset);
+      processor.setMode(i, (SequenceEngine::Mode)mode);
+      reference.seqs[i].calculate(steps, fills);
+      reference.seqs[i].rotate(offset);
+      reference.seqs[i].setMode((ReferenceSequencer::GateSequencerMode)mode);
+    }
+    std::vector<float> clock = randomSignal(n, 40);
+    std::vector<float> reset = randomSignal(n, 400);
+    std::vector<std::vector<float> > gates(count, std::vector<float>(n, -1));
+    std::vector<float*> out(count);
+    // blocks of every length from 1 up, across the 64 sample words
+    for(size_t start=0, len=1; start<n; start+=len, ++len){
+      if(start + len > n)
+	len = n - start;
+      for(size_t i=0; i<count; ++i)
+	out[i] = &gates[i][start];
+      processor.process(&clock[start], &reset[start], &out[0], len);
+    }
+    for(size_t s=0; s<n; ++s){
+      reference.sample(clock[s] > 0.5f, reset[s] > 0.5f);
+      for(size_t i=0; i<count; ++i)
+	BOOST_REQUIRE_MESSAGE(gates[i][s] == (reference.seqs[i].gate ? 1.0f : 0.0f),
+			      "kernel " << k << " sequencer " << i << " sample " << s);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testEdgeOnSample){
+  SequenceProcessor processor(1);
+  processor.calculate(0, 1, 1);
+  processor.setMode(0, SequenceEngine::TRIGGERING);
+  float clock[100] = {};
+  for(int s=37; s<70; ++s)
+    clock[s] = 1;
+  float gate[100];
+  float* out[] = { gate };
+  processor.process(clock, NULL, out, 100);
+  for(int s=0; s<100; ++s)
+    BOOST_CHECK_EQUAL(gate[s], s >= 37 && s < 70 ? 1.0f : 0.0f);
+}
@@ -1,5 +1,5 @@
 /*
-g++ -g -I../RebelTechnology/Libraries/wiring -I../RebelTechnology/Libraries/avrsim -I/opt/local/include -L/opt/local/lib -o SequenceTest -lboost_unit_test_framework  SequenceTest.cpp ../RebelTechnology/Libraries/avrsim/avr/io.c ../RebelTechnology/Libraries/wiring/serial.c  && ./SequenceTest
+make build/sim/SequenceTest && ./build/sim/SequenceTest
 */
 #define SERIAL_DEBUG
 #define BOOST_TEST_DYN_LINK
@@ -199,3 +199,50 @@ BOOST_AUTO_TEST_CASE(testRotateAndResetIsStrictlyMonotonic){
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(testSeekMatchesNext){
+  Sequence32 seq;
+  for(int len=1; len<=32; ++len){
+    seq.calculate(len, len/3);
+    for(int rot=0; rot<len; rot+=3){
+      seq.rotate(rot);
+      seq.reset();
+      for(int i=0; i<len*3; ++i){
+	bool expect = seq.peek(i);
+	Sequence32 other = seq;
+	other.seek(i);
+	BOOST_CHECK_EQUAL(other.next(), expect);
+	BOOST_CHECK_EQUAL(seq.next(), expect);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testCycleCount){
+  Sequence32 seq;
+  seq.calculate(7, 3);
+  seq.rotate(2);
+  seq.reset();
+  BOOST_CHECK_EQUAL(seq.getCycle(), 0);
+  for(int i=0; i<7*5+3; ++i)
+    seq.next();
+  BOOST_CHECK_EQUAL(seq.getStep(), 7*5+3);
+  BOOST_CHECK_EQUAL(seq.getCycle(), 5);
+  seq.seek(7*11+1);
+  BOOST_CHECK_EQUAL(seq.getCycle(), 11);
+  seq.reset();
+  BOOST_CHECK_EQUAL(seq.getStep(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(testStepCounterWraps){
+  Sequence32 seq;
+  seq.calculate(7, 3);
+  seq.seek(65535);
+  BOOST_CHECK_EQUAL(seq.getCycle(), 65535/7);
+  BOOST_CHECK_EQUAL(seq.next(), seq.peek(65535));
+  BOOST_CHECK_EQUAL(seq.getStep(), 0);
+  BOOST_CHECK_EQUAL(seq.getCycle(), 0);
+  // the pattern plays on from step 65536, only the counts restart
+  BOOST_CHECK_EQUAL(seq.next(), seq.peek(65536 % 7));
+  BOOST_CHECK_EQUAL(seq.getStep(), 1);
+}
@@ -0,0 +1,101 @@
+/*
+make build/sim/SequencerLibraryTest && ./build/sim/SequencerLibraryTest
+
+Tests the C API of the host library, against the golden pattern corpus
+of the firmware GateSequencer (see sim/golden.h for the layout).
+*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Test
+#include <boost/test/unit_test.hpp>
+#include <stdio.h>
+#include <vector>
+#include "sequencer.h"
+
+#define GOLDEN_HEADER_SIZE   8
+#define GOLDEN_MAX_STEPS     32
+
+static const enum sequencer_mode modes[] = {
+  SEQUENCER_DISABLED, SEQUENCER_TRIGGERING, SEQUENCER_ALTERNATING
+};
+
+std::vector<uint8_t> readCorpus(const char* file){
+  std::vector<uint8_t> data;
+  FILE* in = fopen(file, "rb");
+  if(in){
+    uint8_t buf[4096];
+    size_t len;
+    while((len = fread(buf, 1, sizeof(buf), in)) > 0)
+      data.insert(data.end(), buf, buf+len);
+    fclose(in);
+  }
+  return data;
+}
+
+BOOST_AUTO_TEST_CASE(testGoldenCorpus){
+  std::vector<uint8_t> golden = readCorpus("golden.bin");
+  BOOST_REQUIRE_MESSAGE(golden.size() > GOLDEN_HEADER_SIZE, "cannot read golden.bin");
+  BOOST_REQUIRE_EQUAL(golden[5], GOLDEN_MAX_STEPS);
+  size_t offset = GOLDEN_HEADER_SIZE;
+  sequencer seq;
+  sequencer_init(&seq);
+  for(uint8_t n=1; n<=GOLDEN_MAX_STEPS; ++n){
+    for(uint8_t f=0; f<=n; ++f){
+      uint32_t bits;
+      BOOST_REQUIRE_EQUAL(sequencer_pattern(n, f, &bits), 0);
+      BOOST_REQUIRE_EQUAL(sequencer_calculate(&seq, n, f), 0);
+      BOOST_REQUIRE_EQUAL(sequencer_bits(&seq), bits);
+      for(uint8_t i=0; i<(n+7)/8; ++i)
+	BOOST_REQUIRE_MESSAGE(golden[offset++] == (uint8_t)(bits >> (i*8)),
+			      "pattern differs: steps " << (int)n << " fills " << (int)f);
+      for(uint8_t r=0; r<n; ++r){
+	for(uint8_t m=0; m<3; ++m){
+	  sequencer_set_mode(&seq, modes[m]);
+	  sequencer_rotate(&seq, r);
+	  sequencer_reset(&seq);
+	  uint8_t gates[GOLDEN_MAX_STEPS/2] = {};
+	  for(uint8_t i=0; i<4*n; i+=2){
+	    gates[i/8] |= sequencer_rise(&seq) << (i%8);
+	    gates[i/8] |= sequencer_fall(&seq) << (i%8+1);
+	  }
+	  for(uint8_t i=0; i<(n+1)/2; ++i)
+	    BOOST_REQUIRE_MESSAGE(golden[offset++] == gates[i],
+				  "gates differ: steps " << (int)n << " fills " << (int)f <<
+				  " rotation " << (int)r << " mode " << (int)m);
+	}
+      }
+    }
+  }
+  BOOST_CHECK_EQUAL(offset, golden.size());
+}
+
+BOOST_AUTO_TEST_CASE(testParametersOutOfRange){
+  sequencer seq;
+  sequencer_init(&seq);
+  BOOST_CHECK_EQUAL(sequencer_calculate(&seq, 8, 3), 0);
+  uint32_t bits = sequencer_bits(&seq);
+  BOOST_CHECK_EQUAL(sequencer_calculate(&seq, 0, 0), -1);
+  BOOST_CHECK_EQUAL(sequencer_calculate(&seq, SEQUENCER_MAX_STEPS+1, 1), -1);
+  BOOST_CHECK_EQUAL(sequencer_calculate(&seq, 8, 9), -1);
+  BOOST_CHECK_EQUAL(sequencer_rotate(&seq, -1), -1);
+  BOOST_CHECK_EQUAL(sequencer_set_mode(&seq, (enum sequencer_mode)3), -1);
+  BOOST_CHECK_EQUAL(sequencer_pattern(0, 0, &bits), -1);
+  BOOST_CHECK_EQUAL(sequencer_length(&seq), 8);
+  BOOST_CHECK_EQUAL(sequencer_bits(&seq), bits);
+}
+
+BOOST_AUTO_TEST_CASE(testCopyState){
+  sequencer a, b;
+  sequencer_init(&a);
+  sequencer_calculate(&a, 13, 5);
+  sequencer_rotate(&a, 3);
+  sequencer_set_mode(&a, SEQUENCER_ALTERNATING);
+  sequencer_reset(&a);
+  for(int i=0; i<7; ++i)
+    sequencer_rise(&a);
+  b = a;
+  BOOST_CHECK_EQUAL(sequencer_position(&b), sequencer_position(&a));
+  BOOST_CHECK_EQUAL(sequencer_steps_played(&b), 7);
+  for(int i=0; i<40; ++i)
+    BOOST_CHECK_EQUAL(sequencer_rise(&b), sequencer_rise(&a));
+  BOOST_CHECK_EQUAL(sequencer_cycles_played(&a), 47 / 13);
+}
@@ -12,6 +12,21 @@
 #include "serial.h"
 #endif // SERIAL_DEBUG
 
+#ifdef SEQUENCER_DIAGNOSTICS
+Diagnostics diagnostics;
+#endif
+#ifdef SEQUENCER_PROFILE
+Profiler profiler;
+#endif
+#ifdef SEQUENCER_LATENCY
+LatencyMeter latency;
+
+ISR(TIMER1_OVF_vect){
+  latency.overflow();
+  DIAGNOSTICS_EXIT(DIAGNOSTICS_TIMER1_OVF);
+}
+#endif
+
 inline bool clockIsHigh(){
   return !(SEQUENCER_CLOCK_PINS & _BV(SEQUENCER_CLOCK_PIN));
 }
@@ -27,13 +42,16 @@ GateSequencer seq(SEQUENCER_OUTPUT_PIN,
 
 /* Reset interrupt */
 SIGNAL(INT0_vect){
+  PROFILE_SCOPE(PROFILE_INT0);
   seq.reset();
   // hold everything until reset is released
   while(resetIsHigh());
+  DIAGNOSTICS_EXIT(DIAGNOSTICS_INT0);
 }
 
 /* Clock interrupt */
 SIGNAL(INT1_vect){
+  PROFILE_SCOPE(PROFILE_INT1);
   if(clockIsHigh()){
     seq.rise();
     SEQUENCER_LEDS_PORT |= _BV(SEQUENCER_LED_B_PIN);
@@ -43,6 +61,7 @@ SIGNAL(INT1_vect){
   }
   // debug
 //   PORTB ^= _BV(PORTB4);
+  DIAGNOSTICS_EXIT(DIAGNOSTICS_INT1);
 }
 
 void setup(){
@@ -62,11 +81,19 @@ void setup(){
   setup_adc();
   SEQUENCER_LEDS_DDR |= _BV(SEQUENCER_LED_A_PIN);
   SEQUENCER_LEDS_DDR |= _BV(SEQUENCER_LED_B_PIN);
+#ifdef SEQUENCER_PROFILE
+  profiler.begin();
+#endif
+#ifdef SEQUENCER_LATENCY
+  latency.begin();
+#endif
   sei();
 
 #ifdef SERIAL_DEBUG
   beginSerial(9600);
   printString("hello\n");
+#elif defined(SEQUENCER_DIAGNOSTICS) || defined(SEQUENCER_PROFILE) || defined(SEQUENCER_LATENCY)
+  beginSerial(9600);
 #endif
 }
 
@@ -76,9 +103,11 @@ void loop(){
   seq.fill.update(getAnalogValue(SEQUENCER_FILL_CONTROL));
   seq.update();
 
-#ifdef SERIAL_DEBUG
+#if defined(SERIAL_DEBUG) || defined(SEQUENCER_DIAGNOSTICS) || defined(SEQUENCER_PROFILE) || defined(SEQUENCER_LATENCY)
   if(serialAvailable() > 0){
-    serialRead();
+    uint8_t command = serialRead();
+    (void)command; // only read by the 'c' of the counters
+#ifdef SERIAL_DEBUG
     printString("a: [");
     seq.dump();
     printString("] ");
@@ -88,6 +117,22 @@ void loop(){
     if(resetIsHigh())
       printString(" reset high");
     printNewline();
+#endif
+#ifdef SEQUENCER_DIAGNOSTICS
+    diagnostics.print();
+    if(command == 'c')
+      diagnostics.clear();
+#endif
+#ifdef SEQUENCER_PROFILE
+    profiler.print();
+    if(command == 'c')
+      profiler.clear();
+#endif
+#ifdef SEQUENCER_LATENCY
+    latency.print();
+    if(command == 'c')
+      latency.clear();
+#endif
   }
 #endif
 }
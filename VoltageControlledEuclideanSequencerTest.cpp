@@ -1,5 +1,5 @@
 /*
-g++ -I../RebelTechnology/Libraries/wiring -I../RebelTechnology/Libraries/avrsim -I/opt/local/include -L/opt/local/lib -o VoltageControlledEuclideanSequencerTest -lboost_unit_test_framework  VoltageControlledEuclideanSequencerTest.cpp ../RebelTechnology/Libraries/avrsim/avr/io.c ../RebelTechnology/Libraries/wiring/serial.c ../RebelTechnology/Libraries/avrsim/avr/interrupt.c && ./VoltageControlledEuclideanSequencerTest
+make build/sim/VoltageControlledEuclideanSequencerTest && ./build/sim/VoltageControlledEuclideanSequencerTest
 */
 // #define mcu atmega168
 
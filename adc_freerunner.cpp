@@ -1,4 +1,7 @@
 #include "adc_freerunner.h"
+#include "Diagnostics.h"
+#include "Profile.h"
+#include "Latency.h"
 
 #include <avr/interrupt.h> 
 
@@ -24,6 +27,7 @@ void setup_adc(){
 }
 
 ISR(ADC_vect) {
+  PROFILE_SCOPE(PROFILE_ADC);
   static uint8_t oldchan;
   static uint8_t counter;
   static uint16_t adc_buffer[ADC_CHANNELS];
@@ -35,10 +39,12 @@ ISR(ADC_vect) {
     if(++counter == ADC_OVERSAMPLING){
       counter = 0;
       for(uint8_t i=0; i<ADC_CHANNELS; ++i){
+	LATENCY_INPUT(adc_values[i], adc_buffer[i]);
 	adc_values[i] = adc_buffer[i];
 	adc_buffer[i] = 0;
       }
     }
   }
   ADMUX = (ADMUX & ~7) | curchan;
+  DIAGNOSTICS_EXIT(DIAGNOSTICS_ADC);
 }
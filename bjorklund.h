@@ -21,41 +21,52 @@
   for m=32, l+1 < 9
 */
 
-template<typename T, uint8_t BJORKLUND_ARRAY_SIZE>
-class Bjorklund {
+/**
+  The recursion of the algorithm: on return, the pattern of level l is
+  count[l] patterns of level l-1 followed, if remainder[l] is not 0, by
+  one of level l-2, where level -1 is a gap and level -2 a pulse, and the
+  whole pattern is that of the returned level. I is the integer type of
+  the counts, wide enough for the number of slots. Shared with the lazy
+  iterator of lib/RhythmIterator.h, which walks the same recursion.
+*/
+template<typename I, uint8_t BJORKLUND_ARRAY_SIZE>
+class BjorklundLevels {
 public:
-  T compute(int8_t slots, int8_t pulses){
-    bits = 0UL;
-    pos = 0;
-    if(!pulses)
-      return bits;
+  /* slots and pulses must be positive */
+  int8_t levels(I slots, I pulses){
     /* Figure 11 */
-    int8_t divisor = slots - pulses;
+    I divisor = slots - pulses;
     remainder[0] = pulses; 
     int8_t level = 0; 
-    int8_t cycleLength = 1; 
-    int8_t remLength = 1;
     do { 
       count[level] = divisor / remainder[level]; 
       remainder[level+1] = divisor % remainder[level]; 
       divisor = remainder[level]; 
-      int8_t newLength = (cycleLength * count[level]) + remLength; 
-      remLength = cycleLength; 
-      cycleLength = newLength; 
       level = level + 1;
     }while(remainder[level] > 1);
     count[level] = divisor; 
-    if(remainder[level] > 0)
-      cycleLength = (cycleLength * count[level]) + remLength;
-    build(level);
+    return level;
+  }
+
+  I remainder[BJORKLUND_ARRAY_SIZE];
+  I count[BJORKLUND_ARRAY_SIZE];
+};
+
+template<typename T, uint8_t BJORKLUND_ARRAY_SIZE>
+class Bjorklund : private BjorklundLevels<int8_t, BJORKLUND_ARRAY_SIZE> {
+public:
+  T compute(int8_t slots, int8_t pulses){
+    bits = 0UL;
+    pos = 0;
+    if(!pulses)
+      return bits;
+    build(this->levels(slots, pulses));
     return bits;
   }
 
 private:
   T bits;
   uint8_t pos;
-  int8_t remainder[BJORKLUND_ARRAY_SIZE];
-  int8_t count[BJORKLUND_ARRAY_SIZE];
 
   void build(int8_t level){
     if(level == -1){
@@ -64,9 +75,9 @@ private:
     }else if(level == -2){
       bits |= 1UL<<pos++;
     }else{ 
-      for(int8_t i=0; i < count[level]; i++)
+      for(int8_t i=0; i < this->count[level]; i++)
 	build(level-1); 
-      if(remainder[level] != 0)
+      if(this->remainder[level] != 0)
 	build(level-2); 
     }
   }
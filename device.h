@@ -7,6 +7,46 @@
 #define SEQUENCER_STEP_SCALING_FACTOR       8
 #define SEQUENCER_DEADBAND_THRESHOLD        (ADC_VALUE_RANGE/SEQUENCER_STEPS_RANGE/4)
 
+/* show A XOR B (or AND, OR, AND_NOT) on LED C instead of the clock */
+// #define SEQUENCER_COMBINE_OPERATION         XOR
+#define SEQUENCER_COMBINED_PERIOD           (SEQUENCER_STEPS_RANGE*(SEQUENCER_STEPS_RANGE-1))
+
+/* play both channels from a cache of their whole cycle, lcm(A, B) steps
+   or A + B chained, of up to SEQUENCER_CYCLE_CACHE_PERIOD steps and a
+   quarter as many bytes; longer cycles are stepped live, see CycleCache.h */
+// #define SEQUENCER_CYCLE_CACHE
+#define SEQUENCER_CYCLE_CACHE_PERIOD        SEQUENCER_COMBINED_PERIOD
+
+/* compute the patterns with the Bresenham walk of Bresenham.h from a
+   table of start phases in program memory, instead of the Bjorklund
+   recursion; the same patterns for a 561 byte table. Faster on the
+   host, the cycles on the module are not measured yet */
+// #define SEQUENCER_BRESENHAM
+
+/* step knobs select rhythms from the catalogue in patterns.txt */
+// #define SEQUENCER_RHYTHM_CATALOGUE
+/* and the catalogue is the pattern bank in bank.h, see PatternBank.h */
+// #define SEQUENCER_PATTERN_BANK
+
+/* stream the clock, reset, switch and control inputs to the serial port
+   for replay on the host, see InputLog.h; uses Timer1 */
+// #define SEQUENCER_INPUT_LOG
+
+/* count interrupt handler entries and overlaps and measure the stack
+   high-water mark, printed on the serial port, see Diagnostics.h */
+// #define SEQUENCER_DIAGNOSTICS
+
+/* time the interrupt handlers, update() and calculate() with Timer1,
+   printed on the serial port, see Profile.h */
+// #define SEQUENCER_PROFILE
+
+/* measure the latency from a knob move to the first clock edge that
+   plays the new pattern, printed on the serial port, see Latency.h */
+// #define SEQUENCER_LATENCY
+
+/* number of loop() iterations without control changes before saving */
+#define PRESET_SAVE_DELAY                   10000
+
 #define SEQUENCER_FILL_A_CONTROL            0
 #define SEQUENCER_FILL_B_CONTROL            1
 #define SEQUENCER_STEP_A_CONTROL            2
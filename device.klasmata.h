@@ -7,6 +7,21 @@
 #define SEQUENCER_STEP_SCALING_FACTOR       7
 #define SEQUENCER_DEADBAND_THRESHOLD        (ADC_VALUE_RANGE/SEQUENCER_STEPS_RANGE/4)
 
+/* step knob selects rhythms from the catalogue in patterns.txt */
+// #define SEQUENCER_RHYTHM_CATALOGUE
+
+/* count interrupt handler entries and overlaps and measure the stack
+   high-water mark, printed on the serial port, see Diagnostics.h */
+// #define SEQUENCER_DIAGNOSTICS
+
+/* time the interrupt handlers, update() and calculate() with Timer1,
+   printed on the serial port, see Profile.h */
+// #define SEQUENCER_PROFILE
+
+/* measure the latency from a knob move to the first clock edge that
+   plays the new pattern, printed on the serial port, see Latency.h */
+// #define SEQUENCER_LATENCY
+
 #define SEQUENCER_ROTATE_CONTROL            0
 #define SEQUENCER_FILL_CONTROL              1
 #define SEQUENCER_STEP_CONTROL              2
@@ -0,0 +1,150 @@
+#ifndef _EUCLIDEAN_GENERATOR_H_
+#define _EUCLIDEAN_GENERATOR_H_
+
+/**
+   Euclidean patterns from the closed form, for bulk generation on the
+   host: step i of E(fills, steps) is set iff (p + i * fills) mod steps is
+   below fills, from the start phase p of the Bjorklund pattern in the
+   table of phases.h. That is the walk of Bresenham.h, the algorithm
+   policy for Sequence, eg Sequence<uint32_t, Bresenham<uint32_t> >, and
+   every generator here returns exactly what Bjorklund::compute does.
+
+   EuclideanGenerator fills arrays of patterns, each lane of an SSE2 or
+   AVX2 kernel stepping the phase of its own pattern with an add and a
+   compare per step. Patterns have up to 32 steps.
+*/
+
+#include <inttypes.h>
+#include <stddef.h>
+#include "Bresenham.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define EUCLIDEAN_GENERATOR_X86
+#include <immintrin.h>
+#endif
+
+#define EUCLIDEAN_GENERATOR_MAX_STEPS EUCLIDEAN_PHASES_STEPS
+
+class EuclideanGenerator {
+public:
+  enum Kernel {
+    AUTO,
+    SCALAR,
+    SSE2,
+    AVX2
+  };
+
+  static bool supported(Kernel k){
+    switch(k){
+    case AUTO:
+    case SCALAR:
+      return true;
+#ifdef EUCLIDEAN_GENERATOR_X86
+    case SSE2:
+      return __builtin_cpu_supports("sse2");
+    case AVX2:
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+    }
+  }
+
+  /* the fastest supported kernel for AUTO, an unsupported one is SCALAR */
+  EuclideanGenerator(Kernel k = AUTO){
+    kernel = supported(k) ? k : SCALAR;
+    if(k == AUTO)
+      kernel = supported(AVX2) ? AVX2 : supported(SSE2) ? SSE2 : SCALAR;
+  }
+
+  Kernel getKernel() const {
+    return kernel;
+  }
+
+  /* bits[j] = E(fills[j], steps[j]), steps from 1 to 32 and fills up to steps */
+  void generate(const uint8_t* steps, const uint8_t* fills, uint32_t* bits, size_t count){
+    size_t j = 0;
+    switch(kernel){
+#ifdef EUCLIDEAN_GENERATOR_X86
+    case AVX2:
+      j = generateAvx2(steps, fills, bits, count);
+      break;
+    case SSE2:
+      j = generateSse2(steps, fills, bits, count);
+      break;
+#endif
+    default:
+      break;
+    }
+    Bresenham<uint32_t> walk;
+    for(; j<count; ++j)
+      bits[j] = walk.compute(steps[j], fills[j]);
+  }
+
+private:
+  static inline uint8_t phase(uint8_t steps, uint8_t fills){
+    return pgm_read_byte(&euclideanPhases[steps * (steps + 1) / 2 + fills]);
+  }
+
+  static inline uint32_t mask(uint8_t steps){
+    return steps == 32 ? 0xffffffffUL : (1UL << steps) - 1;
+  }
+
+#ifdef EUCLIDEAN_GENERATOR_X86
+  /* whole groups of 4 patterns, returns how many it generated */
+  __attribute__((target("sse2")))
+  static size_t generateSse2(const uint8_t* steps, const uint8_t* fills, uint32_t* bits, size_t count){
+    size_t j = 0;
+    for(; j+4<=count; j+=4){
+      __m128i n = _mm_setr_epi32(steps[j], steps[j+1], steps[j+2], steps[j+3]);
+      __m128i k = _mm_setr_epi32(fills[j], fills[j+1], fills[j+2], fills[j+3]);
+      __m128i p = _mm_setr_epi32(phase(steps[j], fills[j]), phase(steps[j+1], fills[j+1]),
+				 phase(steps[j+2], fills[j+2]), phase(steps[j+3], fills[j+3]));
+      __m128i bit = _mm_set1_epi32(1);
+      __m128i b = _mm_setzero_si128();
+      for(uint8_t i=0; i<EUCLIDEAN_GENERATOR_MAX_STEPS; ++i){
+	b = _mm_or_si128(b, _mm_and_si128(_mm_cmplt_epi32(p, k), bit));
+	p = _mm_add_epi32(p, k);
+	p = _mm_sub_epi32(p, _mm_andnot_si128(_mm_cmplt_epi32(p, n), n));
+	bit = _mm_add_epi32(bit, bit);
+      }
+      uint32_t out[4];
+      _mm_storeu_si128((__m128i*)out, b);
+      // no per-lane shifts before AVX2
+      for(uint8_t l=0; l<4; ++l)
+	bits[j+l] = out[l] & mask(steps[j+l]);
+    }
+    return j;
+  }
+
+  __attribute__((target("avx2")))
+  static size_t generateAvx2(const uint8_t* steps, const uint8_t* fills, uint32_t* bits, size_t count){
+    size_t j = 0;
+    const __m256i one = _mm256_set1_epi32(1);
+    for(; j+8<=count; j+=8){
+      __m256i n = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(steps + j)));
+      __m256i k = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(fills + j)));
+      int32_t start[8];
+      for(uint8_t l=0; l<8; ++l)
+	start[l] = phase(steps[j+l], fills[j+l]);
+      __m256i p = _mm256_loadu_si256((const __m256i*)start);
+      __m256i bit = one;
+      __m256i b = _mm256_setzero_si256();
+      for(uint8_t i=0; i<EUCLIDEAN_GENERATOR_MAX_STEPS; ++i){
+	b = _mm256_or_si256(b, _mm256_and_si256(_mm256_cmpgt_epi32(k, p), bit));
+	p = _mm256_add_epi32(p, k);
+	p = _mm256_sub_epi32(p, _mm256_andnot_si256(_mm256_cmpgt_epi32(n, p), n));
+	bit = _mm256_add_epi32(bit, bit);
+      }
+      // shifts by 32 or more give 0, so 1 << 32 - 1 is the mask of 32 steps
+      __m256i mask = _mm256_sub_epi32(_mm256_sllv_epi32(one, n), one);
+      _mm256_storeu_si256((__m256i*)(bits + j), _mm256_and_si256(b, mask));
+    }
+    return j;
+  }
+#endif /* EUCLIDEAN_GENERATOR_X86 */
+
+  Kernel kernel;
+};
+
+#endif /* _EUCLIDEAN_GENERATOR_H_ */
@@ -0,0 +1,233 @@
+#ifndef _NECKLACE_INDEX_H_
+#define _NECKLACE_INDEX_H_
+
+/**
+   Reverse lookup of Euclidean rhythms: given a gate pattern of up to 64
+   steps, eg captured from another module, which (steps, fills, rotation)
+   plays it. Step i of a pattern is bit i, the i-th step after a reset,
+   so a sequencer with calculate(steps, fills), rotate(rotation) and
+   reset() plays step i of its pattern word at bit (i + rotation) mod
+   steps, as Sequence::rotate sets it.
+
+   Patterns are compared by their necklace, the rotation with the least
+   value, found with word rotations: only the rotations that start on a
+   pulse after a gap can be least, so there are at most as many
+   candidates as pulses. The index is a hash table of the necklaces of
+   every E(fills, steps) up to 64 steps with their rotation from the
+   Bjorklund pattern, with open addressing, in one block that is written
+   to a file and used in place with mmap(), or from memory. A lookup
+   hashes the necklace and probes a slot or two.
+
+   File layout, little endian: a 16 byte header ("NECK", version, max
+   steps, 0, 0, the number of slots and of entries as 32-bit words, 0),
+   then the slots of 16 bytes: the necklace as a 64-bit word, steps,
+   fills and rotation as bytes and 5 bytes of 0. Empty slots have 0
+   steps.
+*/
+
+#include <inttypes.h>
+#include <string.h>
+#include <stddef.h>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "Sequence.h"
+
+#define NECKLACE_VERSION         1
+#define NECKLACE_MAX_STEPS       64
+#define NECKLACE_HEADER_SIZE     16
+
+struct NecklaceSlot {
+  uint64_t necklace;
+  uint8_t steps;
+  uint8_t fills;
+  uint8_t rotation;
+  uint8_t reserved[5];
+};
+
+struct NecklaceMatch {
+  uint8_t steps;
+  uint8_t fills;
+  uint8_t rotation;
+};
+
+class NecklaceIndex {
+public:
+  NecklaceIndex() : data(NULL), size(0), mapped(false) {}
+
+  /* an index in memory, which must outlive it */
+  NecklaceIndex(const void* d, size_t s) : data(NULL), size(0), mapped(false) {
+    attach(d, s);
+  }
+
+  ~NecklaceIndex(){
+    close();
+  }
+
+  /* maps an index file, false if it cannot be read or is not an index */
+  bool open(const char* file){
+    close();
+    int fd = ::open(file, O_RDONLY);
+    if(fd < 0)
+      return false;
+    struct stat st;
+    void* p = MAP_FAILED;
+    if(!fstat(fd, &st) && st.st_size >= NECKLACE_HEADER_SIZE)
+      p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(p == MAP_FAILED)
+      return false;
+    if(!attach(p, st.st_size)){
+      munmap(p, st.st_size);
+      return false;
+    }
+    mapped = true;
+    return true;
+  }
+
+  void close(){
+    if(mapped)
+      munmap((void*)data, size);
+    data = NULL;
+    size = 0;
+    mapped = false;
+  }
+
+  bool isOpen() const {
+    return data != NULL;
+  }
+
+  /* the rhythm that plays pattern from a reset, false if none does */
+  bool lookup(uint64_t pattern, uint8_t steps, NecklaceMatch& match) const {
+    if(!data || !steps || steps > NECKLACE_MAX_STEPS)
+      return false;
+    uint8_t r;
+    uint64_t necklace = canonical(pattern & mask(steps), steps, r);
+    const NecklaceSlot* slots = (const NecklaceSlot*)(data + NECKLACE_HEADER_SIZE);
+    for(uint32_t i = hash(necklace, steps) & (buckets - 1); slots[i].steps; i = (i + 1) & (buckets - 1)){
+      if(slots[i].steps == steps && getNecklace(slots[i]) == necklace){
+	// pattern = rotate(necklace, -r) = rotate(bjorklund, slot rotation - r)
+	match.steps = steps;
+	match.fills = slots[i].fills;
+	match.rotation = (slots[i].rotation + steps - r) % steps;
+	return true;
+      }
+    }
+    return false;
+  }
+
+  /* step i of the result is step (i + r) mod steps of bits */
+  static inline uint64_t rotate(uint64_t bits, uint8_t steps, uint8_t r){
+    if(!r)
+      return bits;
+    return ((bits >> r) | (bits << (steps - r))) & mask(steps);
+  }
+
+  static inline uint64_t mask(uint8_t steps){
+    return steps == 64 ? ~0ULL : (1ULL << steps) - 1;
+  }
+
+  /* the least rotation of bits, and in r the rotation that gives it */
+  static uint64_t canonical(uint64_t bits, uint8_t steps, uint8_t& r){
+    r = 0;
+    if(!bits || bits == mask(steps))
+      return bits;
+    // pulses whose previous step, cyclically, is a gap
+    uint64_t starts = bits & ~rotate(bits, steps, steps - 1);
+    uint64_t least = ~0ULL;
+    while(starts){
+      uint8_t i = __builtin_ctzll(starts);
+      starts &= starts - 1;
+      uint64_t v = rotate(bits, steps, i);
+      if(v < least){
+	least = v;
+	r = i;
+      }
+    }
+    return least;
+  }
+
+  /* the index of every Euclidean rhythm up to NECKLACE_MAX_STEPS steps */
+  static std::vector<uint8_t> build(){
+    uint32_t entries = 0;
+    for(uint8_t n=1; n<=NECKLACE_MAX_STEPS; ++n)
+      entries += n + 1;
+    uint32_t slots = 1;
+    while(slots < 2 * entries)
+      slots <<= 1;
+    std::vector<uint8_t> out(NECKLACE_HEADER_SIZE + slots * sizeof(NecklaceSlot), 0);
+    const uint8_t header[8] = { 'N', 'E', 'C', 'K', NECKLACE_VERSION, NECKLACE_MAX_STEPS, 0, 0 };
+    memcpy(&out[0], header, sizeof(header));
+    putWord(&out[8], slots);
+    putWord(&out[12], entries);
+    NecklaceSlot* table = (NecklaceSlot*)&out[NECKLACE_HEADER_SIZE];
+    for(uint8_t n=1; n<=NECKLACE_MAX_STEPS; ++n){
+      for(uint8_t k=0; k<=n; ++k){
+	Bjorklund<uint64_t, SEQUENCE_ALGORITHM_ARRAY_SIZE> algo;
+	uint8_t r;
+	uint64_t necklace = canonical(algo.compute(n, k), n, r);
+	uint32_t i = hash(necklace, n) & (slots - 1);
+	while(table[i].steps)
+	  i = (i + 1) & (slots - 1);
+	putWord((uint8_t*)&table[i].necklace, (uint32_t)necklace);
+	putWord((uint8_t*)&table[i].necklace + 4, (uint32_t)(necklace >> 32));
+	table[i].steps = n;
+	table[i].fills = k;
+	table[i].rotation = r;
+      }
+    }
+    return out;
+  }
+
+private:
+  // a copy would unmap the file a second time
+  NecklaceIndex(const NecklaceIndex&) = delete;
+  NecklaceIndex& operator=(const NecklaceIndex&) = delete;
+
+  /* the words of the file are little endian on any host */
+  static inline void putWord(uint8_t* p, uint32_t w){
+    p[0] = w;
+    p[1] = w >> 8;
+    p[2] = w >> 16;
+    p[3] = w >> 24;
+  }
+
+  static inline uint32_t getWord(const uint8_t* p){
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+  }
+
+  static inline uint64_t getNecklace(const NecklaceSlot& slot){
+    const uint8_t* p = (const uint8_t*)&slot.necklace;
+    return getWord(p) | (uint64_t)getWord(p + 4) << 32;
+  }
+
+  bool attach(const void* d, size_t s){
+    const uint8_t* p = (const uint8_t*)d;
+    if(s < NECKLACE_HEADER_SIZE || memcmp(p, "NECK", 4) || p[4] != NECKLACE_VERSION)
+      return false;
+    uint32_t n = getWord(p + 8);
+    if(!n || (n & (n - 1)) || s < NECKLACE_HEADER_SIZE + (size_t)n * sizeof(NecklaceSlot))
+      return false;
+    data = p;
+    size = s;
+    buckets = n;
+    return true;
+  }
+
+  static inline uint32_t hash(uint64_t necklace, uint8_t steps){
+    uint64_t x = necklace * 0x9e3779b97f4a7c15ULL + steps;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return x;
+  }
+
+  const uint8_t* data;
+  size_t size;
+  uint32_t buckets;
+  bool mapped;
+};
+
+#endif /* _NECKLACE_INDEX_H_ */
@@ -0,0 +1,148 @@
+#ifndef _PATTERN_BANK_FILE_H_
+#define _PATTERN_BANK_FILE_H_
+
+/**
+   Host side of the pattern banks of PatternBank.h. PatternBankFile maps
+   a bank file and reads it in place, with no parsing or copying beyond
+   a check of the header and the word indices, so that banks of hundreds
+   of thousands of entries open at once. PatternBankBuilder assembles the
+   bytes of a bank, sharing the words of equal patterns, and writes them
+   to a file or as bank.h, the array that the firmware flashes to program
+   memory with SEQUENCER_PATTERN_BANK.
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "PatternBank.h"
+
+/* the most distinct pattern words, indexed by 16 bits */
+#define PATTERN_BANK_MAX_WORDS   65536
+
+class PatternBankFile {
+public:
+  PatternBankFile() : data(NULL), size(0) {}
+
+  ~PatternBankFile(){
+    close();
+  }
+
+  /* false if the file cannot be read or is not a bank */
+  bool open(const char* file){
+    close();
+    int fd = ::open(file, O_RDONLY);
+    if(fd < 0)
+      return false;
+    struct stat st;
+    void* p = MAP_FAILED;
+    if(!fstat(fd, &st) && st.st_size >= PATTERN_BANK_HEADER_SIZE)
+      p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(p == MAP_FAILED)
+      return false;
+    if(!PatternBank((const uint8_t*)p).check(st.st_size)){
+      munmap(p, st.st_size);
+      return false;
+    }
+    data = (const uint8_t*)p;
+    size = st.st_size;
+    return true;
+  }
+
+  void close(){
+    if(data)
+      munmap((void*)data, size);
+    data = NULL;
+    size = 0;
+  }
+
+  bool isOpen() const {
+    return data != NULL;
+  }
+
+  PatternBank getBank() const {
+    return PatternBank(data);
+  }
+
+private:
+  const uint8_t* data;
+  size_t size;
+};
+
+class PatternBankBuilder {
+public:
+  /* adds an entry, with the pattern word of each channel in bits; the
+     word indices of the entry are ignored. False if the bank already
+     has as many distinct words as it can index. */
+  bool add(const PatternBankEntry& entry, const uint32_t* bits){
+    PatternBankEntry e = entry;
+    for(uint8_t c=0; c<PATTERN_BANK_CHANNELS; ++c){
+      std::map<uint32_t, uint16_t>::iterator it = index.find(bits[c]);
+      if(it == index.end()){
+	if(words.size() == PATTERN_BANK_MAX_WORDS)
+	  return false;
+	it = index.insert(std::make_pair(bits[c], (uint16_t)words.size())).first;
+	words.push_back(bits[c]);
+      }
+      e.channels[c].word = it->second;
+    }
+    memset(e.reserved, 0, sizeof(e.reserved));
+    entries.push_back(e);
+    return true;
+  }
+
+  size_t getEntries() const {
+    return entries.size();
+  }
+
+  /* the bytes of the bank */
+  std::vector<uint8_t> build() const {
+    uint32_t counts[2] = { (uint32_t)entries.size(), (uint32_t)words.size() };
+    std::vector<uint8_t> out(PATTERN_BANK_HEADER_SIZE, 0);
+    memcpy(&out[0], "SBNK", 4);
+    out[4] = PATTERN_BANK_VERSION;
+    out[5] = PATTERN_BANK_CHANNELS;
+    memcpy(&out[8], counts, sizeof(counts));
+    const uint8_t* e = (const uint8_t*)entries.data();
+    out.insert(out.end(), e, e + entries.size() * sizeof(PatternBankEntry));
+    const uint8_t* w = (const uint8_t*)words.data();
+    out.insert(out.end(), w, w + words.size() * sizeof(uint32_t));
+    return out;
+  }
+
+  /* writes the bank to a file, false on error */
+  static bool write(const std::vector<uint8_t>& bank, const char* file){
+    FILE* out = fopen(file, "wb");
+    if(!out)
+      return false;
+    bool ok = fwrite(&bank[0], 1, bank.size(), out) == bank.size();
+    return !fclose(out) && ok;
+  }
+
+  /* writes a bank as bank.h, an array in program memory for the firmware */
+  static bool writeProgmem(const std::vector<uint8_t>& bank, FILE* out){
+    PatternBank b(&bank[0]);
+    fprintf(out, "/* generated by sim/bank - do not edit */\n");
+    fprintf(out, "#ifndef _BANK_H_\n#define _BANK_H_\n\n");
+    fprintf(out, "#define PATTERN_BANK_SIZE %lu\n", (unsigned long)bank.size());
+    fprintf(out, "#define PATTERN_BANK_ENTRIES %" PRIu32 "\n\n", b.getEntries());
+    fprintf(out, "const uint8_t patternBank[PATTERN_BANK_SIZE] PROGMEM __attribute__((aligned(4))) = {");
+    for(size_t i=0; i<bank.size(); ++i)
+      fprintf(out, "%s0x%02x,", i % 16 ? " " : "\n  ", bank[i]);
+    fprintf(out, "\n};\n\n#endif /* _BANK_H_ */\n");
+    return !ferror(out);
+  }
+
+private:
+  std::vector<PatternBankEntry> entries;
+  std::vector<uint32_t> words;
+  std::map<uint32_t, uint16_t> index;
+};
+
+#endif /* _PATTERN_BANK_FILE_H_ */
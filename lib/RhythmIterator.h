@@ -0,0 +1,242 @@
+#ifndef _RHYTHM_ITERATOR_H_
+#define _RHYTHM_ITERATOR_H_
+
+/**
+   Euclidean rhythms of up to 2^63 steps, without materialising them.
+   EuclideanRhythm keeps the levels of the Bjorklund recursion, from the
+   same BjorklundLevels as Bjorklund::compute, and the length and number
+   of pulses of the pattern of each level, so that the step at, or the
+   pulses before, any position are found by descending the O(log n)
+   levels. RhythmIterator plays a rhythm as Sequence does, with the same
+   offset, reset, seek and rotate arithmetic: it keeps the path from the
+   top level down to the current step, so that next() is amortised O(1),
+   and skip() and seek() descend afresh in O(log n). Memory is constant,
+   a few kilobytes whatever the length.
+*/
+
+#include <inttypes.h>
+#include <stddef.h>
+#include "bjorklund.h"
+
+/* enough for the Fibonacci worst case of 64-bit counts */
+#define RHYTHM_LEVELS            96
+
+class EuclideanRhythm : private BjorklundLevels<uint64_t, RHYTHM_LEVELS> {
+public:
+  /* E(fills, steps), steps at least 1 and fills up to steps */
+  EuclideanRhythm(uint64_t steps, uint64_t fills) : length(steps), fills(fills) {
+    top = fills ? levels(steps, fills) : -1;
+    for(int8_t l=0; l<=top; ++l){
+      lengths[l] = count[l] * size(l-1) + (remainder[l] ? size(l-2) : 0);
+      onsets[l] = count[l] * pulses(l-1) + (remainder[l] ? pulses(l-2) : 0);
+    }
+  }
+
+  uint64_t getLength() const {
+    return length;
+  }
+
+  uint64_t getFills() const {
+    return fills;
+  }
+
+  /* the step at a position below the length */
+  bool at(uint64_t position) const {
+    if(!fills)
+      return false;
+    int8_t l = top;
+    while(l >= 0)
+      l = child(l, position, NULL);
+    return l == -2;
+  }
+
+  /* the number of pulses before a position */
+  uint64_t rank(uint64_t position) const {
+    if(!fills)
+      return 0;
+    uint64_t before = 0;
+    int8_t l = top;
+    while(l >= 0)
+      l = child(l, position, &before);
+    return before;
+  }
+
+  /* the position of pulse i, i below the number of fills */
+  uint64_t select(uint64_t i) const {
+    uint64_t position = 0;
+    int8_t l = top;
+    while(l >= 0){
+      uint64_t p = pulses(l-1);
+      uint64_t c = p ? i / p : count[l];
+      if(c >= count[l])
+	c = count[l];
+      position += c * size(l-1);
+      i -= c * p;
+      l = c < count[l] ? l-1 : l-2;
+    }
+    return position;
+  }
+
+private:
+  friend class RhythmIterator;
+
+  inline uint64_t size(int8_t l) const {
+    return l < 0 ? 1 : lengths[l];
+  }
+
+  inline uint64_t pulses(int8_t l) const {
+    return l < 0 ? l == -2 : onsets[l];
+  }
+
+  /* the child of level l that holds position, made relative to it */
+  inline int8_t child(int8_t l, uint64_t& position, uint64_t* before) const {
+    uint64_t s = size(l-1);
+    uint64_t c = position / s;
+    if(c >= count[l])
+      c = count[l];
+    position -= c * s;
+    if(before)
+      *before += c * pulses(l-1);
+    return c < count[l] ? l-1 : l-2;
+  }
+
+  uint64_t length;
+  uint64_t fills;
+  int8_t top;
+  uint64_t lengths[RHYTHM_LEVELS];
+  uint64_t onsets[RHYTHM_LEVELS];
+};
+
+class RhythmIterator {
+public:
+  RhythmIterator(const EuclideanRhythm& r) : rhythm(r), offset(0) {
+    reset();
+  }
+
+  void reset(){
+    moveTo(offset % rhythm.length);
+    counter = 0;
+  }
+
+  /* move to absolute step index, as Sequence::seek */
+  void seek(uint64_t step){
+    moveTo((step % rhythm.length + offset % rhythm.length) % rhythm.length);
+    counter = step;
+  }
+
+  /* the offset of step 0, as Sequence::rotate */
+  void rotate(uint64_t steps){
+    uint64_t len = rhythm.length;
+    moveTo((len + pos + steps % len - offset % len) % len);
+    offset = steps;
+  }
+
+  /* value at absolute step index, without changing position */
+  bool peek(uint64_t step) const {
+    return rhythm.at((step % rhythm.length + offset % rhythm.length) % rhythm.length);
+  }
+
+  bool next(){
+    bool bit = leaf == -2;
+    counter++;
+    if(++pos == rhythm.length)
+      moveTo(0);
+    else
+      advance();
+    return bit;
+  }
+
+  /* n steps ahead, in O(log n) */
+  void skip(uint64_t n){
+    counter += n;
+    moveTo((pos + n % rhythm.length) % rhythm.length);
+  }
+
+  /* steps from the current one to the next pulse, 0 on a pulse; the
+     length if there are none */
+  uint64_t untilPulse() const {
+    if(!rhythm.fills)
+      return rhythm.length;
+    uint64_t i = rhythm.rank(pos);
+    if(i < rhythm.fills)
+      return rhythm.select(i) - pos;
+    return rhythm.length - pos + rhythm.select(0);
+  }
+
+  uint64_t getPosition() const {
+    return pos;
+  }
+
+  /* absolute number of steps played since last reset or seek */
+  uint64_t getStep() const {
+    return counter;
+  }
+
+  /* absolute number of full cycles played since last reset or seek */
+  uint64_t getCycle() const {
+    return counter / rhythm.length;
+  }
+
+private:
+  struct Frame {
+    int8_t level;
+    uint64_t child;
+  };
+
+  /* the path from the top level to a position */
+  void moveTo(uint64_t position){
+    pos = position;
+    depth = 0;
+    if(!rhythm.fills){
+      leaf = -1;
+      return;
+    }
+    int8_t l = rhythm.top;
+    while(l >= 0){
+      uint64_t p = position;
+      int8_t c = rhythm.child(l, p, NULL);
+      frames[depth].level = l;
+      frames[depth].child = (position - p) / rhythm.size(l-1);
+      depth++;
+      position = p;
+      l = c;
+    }
+    leaf = l;
+  }
+
+  /* the next step within the cycle */
+  void advance(){
+    if(!rhythm.fills)
+      return;
+    // the deepest level that has another child
+    while(true){
+      Frame& f = frames[depth-1];
+      uint64_t last = rhythm.count[f.level] - (rhythm.remainder[f.level] ? 0 : 1);
+      if(f.child < last){
+	f.child++;
+	break;
+      }
+      depth--;
+    }
+    // then the first step of that child
+    Frame& f = frames[depth-1];
+    int8_t l = f.child < rhythm.count[f.level] ? f.level-1 : f.level-2;
+    while(l >= 0){
+      frames[depth].level = l;
+      frames[depth].child = rhythm.count[l] ? 0 : rhythm.count[l];
+      depth++;
+      l = rhythm.count[l] ? l-1 : l-2;
+    }
+    leaf = l;
+  }
+
+  const EuclideanRhythm& rhythm;
+  uint64_t offset;
+  uint64_t pos;
+  uint64_t counter;
+  int8_t leaf;
+  uint8_t depth;
+  Frame frames[RHYTHM_LEVELS];
+};
+
+#endif /* _RHYTHM_ITERATOR_H_ */
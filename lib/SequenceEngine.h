@@ -0,0 +1,248 @@
+#ifndef _SEQUENCE_ENGINE_H_
+#define _SEQUENCE_ENGINE_H_
+
+/**
+   Many sequencers of up to 32 steps, stepped together, for host
+   renderers. Each behaves as a GateSequence<uint32_t>, with the same
+   rotation and gate modes, but the pattern words, ends and positions of
+   all of them are kept in contiguous arrays, and the gates in a bitmap,
+   64 sequencers to a word.
+
+   The position of a sequencer is a one-hot cursor, doubled at each step
+   and wrapped to bit 0 at the end of the pattern, so that a step of all
+   the sequencers is an and, an add and a compare per lane, without
+   variable shifts: SSE2 steps 4 sequencers and AVX2 8 at once. The
+   kernel is chosen at run time, or may be forced for tests.
+*/
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <vector>
+#include "Sequence.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SEQUENCE_ENGINE_X86
+#include <immintrin.h>
+#endif
+
+#define SEQUENCE_ENGINE_MAX_STEPS 32
+
+class SequenceEngine {
+public:
+  enum Mode {
+    DISABLED                   =  0,
+    TRIGGERING                 =  1,
+    ALTERNATING                =  2
+  };
+  enum Kernel {
+    AUTO,
+    SCALAR,
+    SSE2,
+    AVX2
+  };
+
+  /* count sequencers of one step with no fills, disabled, gates off */
+  SequenceEngine(size_t count, Kernel k = AUTO)
+    : count(count), words((count + 63) / 64),
+      bits(words * 64, 0), cursor(words * 64, 1), end(words * 64, 2),
+      length(count, 1), offset(count, 0),
+      gates(words, 0), triggering(words, 0), alternating(words, 0) {
+    setKernel(k);
+  }
+
+  static bool supported(Kernel k){
+    switch(k){
+    case AUTO:
+    case SCALAR:
+      return true;
+#ifdef SEQUENCE_ENGINE_X86
+    case SSE2:
+      return __builtin_cpu_supports("sse2");
+    case AVX2:
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+    }
+  }
+
+  /* the fastest supported kernel for AUTO, an unsupported one is SCALAR */
+  void setKernel(Kernel k){
+    kernel = supported(k) ? k : SCALAR;
+    if(k == AUTO)
+      kernel = supported(AVX2) ? AVX2 : supported(SSE2) ? SSE2 : SCALAR;
+  }
+
+  Kernel getKernel() const {
+    return kernel;
+  }
+
+  size_t size() const {
+    return count;
+  }
+
+  /* replaces the pattern of sequencer i, steps from 1 to 32 */
+  void set(size_t i, uint8_t steps, uint32_t pattern){
+    bits[i] = pattern;
+    length[i] = steps;
+    end[i] = steps == 32 ? 0 : 1UL << steps;
+    if(position(i) >= steps)
+      cursor[i] = 1;
+  }
+
+  void calculate(size_t i, uint8_t steps, uint8_t fills){
+    Bjorklund<uint32_t, SEQUENCE_ALGORITHM_ARRAY_SIZE> algo;
+    set(i, steps, algo.compute(steps, fills));
+  }
+
+  /* as Sequence::rotate, the offset of step 0 from 0 to 127 */
+  void rotate(size_t i, int8_t steps){
+    uint8_t len = length[i];
+    uint8_t pos = (len + position(i) + steps - offset[i] % len) % len;
+    cursor[i] = 1UL << pos;
+    offset[i] = steps;
+  }
+
+  void setMode(size_t i, Mode mode){
+    uint64_t bit = 1ULL << (i & 63);
+    triggering[i/64] &= ~bit;
+    alternating[i/64] &= ~bit;
+    if(mode == TRIGGERING)
+      triggering[i/64] |= bit;
+    else if(mode == ALTERNATING)
+      alternating[i/64] |= bit;
+  }
+
+  /* all sequencers to their first step, gates off */
+  void reset(){
+    for(size_t i=0; i<count; ++i)
+      cursor[i] = 1UL << (offset[i] % length[i]);
+    for(size_t w=0; w<words; ++w)
+      gates[w] = 0;
+  }
+
+  /* a rising clock edge for all sequencers */
+  void rise(){
+    switch(kernel){
+#ifdef SEQUENCE_ENGINE_X86
+    case AVX2:
+      riseAvx2();
+      break;
+    case SSE2:
+      riseSse2();
+      break;
+#endif
+    default:
+      riseScalar();
+      break;
+    }
+  }
+
+  /* a falling clock edge, turns off the gates that are not alternating */
+  void fall(){
+    for(size_t w=0; w<words; ++w)
+      gates[w] &= alternating[w];
+  }
+
+  /* the gate bitmap, sequencer i in bit i % 64 of word i / 64 */
+  const uint64_t* getGates() const {
+    return &gates[0];
+  }
+
+  bool gate(size_t i) const {
+    return gates[i/64] & (1ULL << (i & 63));
+  }
+
+  uint8_t position(size_t i) const {
+    return __builtin_ctz(cursor[i]);
+  }
+
+  uint32_t getBits(size_t i) const {
+    return bits[i];
+  }
+
+  uint8_t getLength(size_t i) const {
+    return length[i];
+  }
+
+private:
+  /* the gates of word w from the fills of its 64 sequencers */
+  inline void play(size_t w, uint64_t fills){
+    gates[w] = ((gates[w] ^ fills) & alternating[w]) | ((gates[w] | fills) & triggering[w]);
+  }
+
+  void riseScalar(){
+    for(size_t w=0; w<words; ++w){
+      uint64_t fills = 0;
+      for(size_t j=0; j<64; ++j){
+	size_t i = w*64 + j;
+	fills |= (uint64_t)((bits[i] & cursor[i]) != 0) << j;
+	cursor[i] += cursor[i];
+	if(cursor[i] == end[i])
+	  cursor[i] = 1;
+      }
+      play(w, fills);
+    }
+  }
+
+#ifdef SEQUENCE_ENGINE_X86
+  __attribute__((target("sse2")))
+  void riseSse2(){
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi32(1);
+    for(size_t w=0; w<words; ++w){
+      uint64_t empty = 0;
+      for(size_t j=0; j<64; j+=4){
+	size_t i = w*64 + j;
+	__m128i b = _mm_loadu_si128((const __m128i*)&bits[i]);
+	__m128i c = _mm_loadu_si128((const __m128i*)&cursor[i]);
+	__m128i e = _mm_loadu_si128((const __m128i*)&end[i]);
+	__m128i f = _mm_cmpeq_epi32(_mm_and_si128(b, c), zero);
+	empty |= (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(f)) << j;
+	c = _mm_add_epi32(c, c);
+	__m128i wrap = _mm_cmpeq_epi32(c, e);
+	c = _mm_or_si128(_mm_andnot_si128(wrap, c), _mm_and_si128(wrap, one));
+	_mm_storeu_si128((__m128i*)&cursor[i], c);
+      }
+      play(w, ~empty);
+    }
+  }
+
+  __attribute__((target("avx2")))
+  void riseAvx2(){
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    for(size_t w=0; w<words; ++w){
+      uint64_t empty = 0;
+      for(size_t j=0; j<64; j+=8){
+	size_t i = w*64 + j;
+	__m256i b = _mm256_loadu_si256((const __m256i*)&bits[i]);
+	__m256i c = _mm256_loadu_si256((const __m256i*)&cursor[i]);
+	__m256i e = _mm256_loadu_si256((const __m256i*)&end[i]);
+	__m256i f = _mm256_cmpeq_epi32(_mm256_and_si256(b, c), zero);
+	empty |= (uint64_t)(uint8_t)_mm256_movemask_ps(_mm256_castsi256_ps(f)) << j;
+	c = _mm256_add_epi32(c, c);
+	__m256i wrap = _mm256_cmpeq_epi32(c, e);
+	c = _mm256_blendv_epi8(c, one, wrap);
+	_mm256_storeu_si256((__m256i*)&cursor[i], c);
+      }
+      play(w, ~empty);
+    }
+  }
+#endif /* SEQUENCE_ENGINE_X86 */
+
+  size_t count;
+  size_t words;
+  Kernel kernel;
+  // padded to whole words with sequencers of one empty step
+  std::vector<uint32_t> bits;
+  std::vector<uint32_t> cursor;
+  std::vector<uint32_t> end;
+  std::vector<uint8_t> length;
+  std::vector<int8_t> offset;
+  std::vector<uint64_t> gates;
+  std::vector<uint64_t> triggering;
+  std::vector<uint64_t> alternating;
+};
+
+#endif /* _SEQUENCE_ENGINE_H_ */
@@ -0,0 +1,115 @@
+#ifndef _SEQUENCE_PROCESSOR_H_
+#define _SEQUENCE_PROCESSOR_H_
+
+/**
+   Block processing of a SequenceEngine for audio rate hosts: clock and
+   reset signals in, a gate signal per sequencer out, with every edge
+   placed on the sample where the input crosses the threshold.
+
+   The inputs are compared with the threshold 64 samples at a time into
+   bitmasks, four samples to an SSE2 compare, and the edges found from
+   the masks, so that the sequencers only step at the edges, and the
+   gates are written as runs of constant level between them. A block
+   makes no allocations or virtual calls, and may have any length.
+
+   As the firmware, a rising reset edge resets all the sequencers and
+   holds them until reset falls. A clock edge meanwhile is played on the
+   release at the level the clock then has, as the clock interrupt that
+   was left pending.
+*/
+
+#include "SequenceEngine.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define SEQUENCE_PROCESSOR_THRESHOLD 0.5f
+
+class SequenceProcessor : public SequenceEngine {
+public:
+  SequenceProcessor(size_t count, Kernel k = AUTO)
+    : SequenceEngine(count, k), threshold(SEQUENCE_PROCESSOR_THRESHOLD),
+      clockHigh(false), resetHigh(false), pending(false) {}
+
+  /* n samples of the clock and reset inputs, and the gate of sequencer i
+     into gateOut[i], 1 when on and 0 when off; resetIn may be NULL */
+  void process(const float* clockIn, const float* resetIn, float* gateOut[], size_t n){
+    size_t from = 0;
+    for(size_t start=0; start<n; start+=64){
+      size_t len = n - start < 64 ? n - start : 64;
+      uint64_t within = len == 64 ? ~0ULL : (1ULL << len) - 1;
+      uint64_t clock = above(clockIn + start, len);
+      uint64_t reset = resetIn ? above(resetIn + start, len) : 0;
+      uint64_t clockEdges = (clock ^ ((clock << 1) | clockHigh)) & within;
+      uint64_t resetEdges = (reset ^ ((reset << 1) | resetHigh)) & within;
+      uint64_t edges = clockEdges | resetEdges;
+      while(edges){
+	size_t s = __builtin_ctzll(edges);
+	uint64_t bit = 1ULL << s;
+	edges &= edges - 1;
+	write(gateOut, from, start + s - from);
+	from = start + s;
+	// the reset interrupt has the higher priority
+	if(resetEdges & bit){
+	  resetHigh = reset & bit;
+	  if(resetHigh)
+	    SequenceEngine::reset();
+	}
+	if(clockEdges & bit)
+	  pending = true;
+	if(pending && !resetHigh){
+	  pending = false;
+	  if(clock & bit)
+	    rise();
+	  else
+	    fall();
+	}
+      }
+      clockHigh = (clock >> (len - 1)) & 1;
+    }
+    write(gateOut, from, n - from);
+  }
+
+  float threshold;
+
+private:
+  /* bit s set where in[s] is above the threshold */
+  uint64_t above(const float* in, size_t len){
+    uint64_t mask = 0;
+    size_t s = 0;
+#if defined(__SSE2__)
+    const __m128 t = _mm_set1_ps(threshold);
+    for(; s+4<=len; s+=4)
+      mask |= (uint64_t)_mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(in + s), t)) << s;
+#endif
+    for(; s<len; ++s)
+      mask |= (uint64_t)(in[s] > threshold) << s;
+    return mask;
+  }
+
+  /* len samples of the current gates from sample start */
+  void write(float* gateOut[], size_t start, size_t len){
+    if(!len)
+      return;
+    const uint64_t* gates = getGates();
+    for(size_t i=0; i<size(); ++i){
+      float level = (gates[i/64] >> (i & 63)) & 1 ? 1.0f : 0.0f;
+      float* out = gateOut[i] + start;
+      size_t s = 0;
+#if defined(__SSE2__)
+      const __m128 v = _mm_set1_ps(level);
+      for(; s+4<=len; s+=4)
+	_mm_storeu_ps(out + s, v);
+#endif
+      for(; s<len; ++s)
+	out[s] = level;
+    }
+  }
+
+  bool clockHigh;
+  bool resetHigh;
+  bool pending;
+};
+
+#endif /* _SEQUENCE_PROCESSOR_H_ */
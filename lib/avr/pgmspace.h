@@ -0,0 +1,16 @@
+#ifndef _LIB_AVR_PGMSPACE_H_
+#define _LIB_AVR_PGMSPACE_H_
+
+/**
+   <avr/pgmspace.h> for the host library: program memory is ordinary
+   memory, eg a pattern bank mapped from a file.
+*/
+
+#include <inttypes.h>
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+
+#endif /* _LIB_AVR_PGMSPACE_H_ */
@@ -0,0 +1,113 @@
+/*
+  The host library, see sequencer.h. Built with lib/ ahead of the
+  firmware headers on the include path, for its <util/atomic.h>.
+*/
+
+#include <new>
+#include "sequencer.h"
+#include "GateSequence.h"
+
+typedef FlagGateSequence<uint32_t> LibrarySequencer;
+
+static_assert(sizeof(LibrarySequencer) <= sizeof(sequencer), "sequencer storage too small");
+static_assert(alignof(LibrarySequencer) <= alignof(sequencer), "sequencer storage misaligned");
+
+static inline LibrarySequencer* get(sequencer* seq){
+  return reinterpret_cast<LibrarySequencer*>(seq->storage);
+}
+
+static inline const LibrarySequencer* get(const sequencer* seq){
+  return reinterpret_cast<const LibrarySequencer*>(seq->storage);
+}
+
+static bool valid(uint8_t steps, uint8_t fills){
+  return steps >= 1 && steps <= SEQUENCER_MAX_STEPS && fills <= steps;
+}
+
+int sequencer_pattern(uint8_t steps, uint8_t fills, uint32_t* bits){
+  if(!valid(steps, fills))
+    return -1;
+  Bjorklund<uint32_t, SEQUENCE_ALGORITHM_ARRAY_SIZE> algo;
+  *bits = algo.compute(steps, fills);
+  return 0;
+}
+
+void sequencer_init(sequencer* seq){
+  new (seq->storage) LibrarySequencer();
+}
+
+int sequencer_calculate(sequencer* seq, uint8_t steps, uint8_t fills){
+  if(!valid(steps, fills))
+    return -1;
+  get(seq)->calculate(steps, fills);
+  return 0;
+}
+
+int sequencer_rotate(sequencer* seq, int8_t offset){
+  if(offset < 0)
+    return -1;
+  get(seq)->rotate(offset);
+  return 0;
+}
+
+int sequencer_set_mode(sequencer* seq, enum sequencer_mode mode){
+  switch(mode){
+  case SEQUENCER_DISABLED:
+    get(seq)->setMode(LibrarySequencer::DISABLED);
+    return 0;
+  case SEQUENCER_TRIGGERING:
+    get(seq)->setMode(LibrarySequencer::TRIGGERING);
+    return 0;
+  case SEQUENCER_ALTERNATING:
+    get(seq)->setMode(LibrarySequencer::ALTERNATING);
+    return 0;
+  }
+  return -1;
+}
+
+int sequencer_rise(sequencer* seq){
+  get(seq)->rise();
+  return get(seq)->gate;
+}
+
+int sequencer_fall(sequencer* seq){
+  get(seq)->fall();
+  return get(seq)->gate;
+}
+
+int sequencer_reset(sequencer* seq){
+  get(seq)->reset();
+  return get(seq)->gate;
+}
+
+void sequencer_seek(sequencer* seq, uint16_t step){
+  get(seq)->seek(step);
+}
+
+int sequencer_peek(const sequencer* seq, uint16_t step){
+  return get(seq)->peek(step);
+}
+
+int sequencer_gate(const sequencer* seq){
+  return get(seq)->gate;
+}
+
+uint32_t sequencer_bits(const sequencer* seq){
+  return get(seq)->bits;
+}
+
+uint8_t sequencer_length(const sequencer* seq){
+  return get(seq)->length;
+}
+
+uint8_t sequencer_position(const sequencer* seq){
+  return get(seq)->pos;
+}
+
+uint16_t sequencer_steps_played(const sequencer* seq){
+  return get(seq)->getStep();
+}
+
+uint16_t sequencer_cycles_played(const sequencer* seq){
+  return get(seq)->getCycle();
+}
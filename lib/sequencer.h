@@ -0,0 +1,65 @@
+#ifndef _SEQUENCER_LIBRARY_H_
+#define _SEQUENCER_LIBRARY_H_
+
+/**
+   C API of the sequencing core: the Bjorklund algorithm, and sequencers
+   with the rotation, position and gate modes of the firmware, built from
+   the same Sequence.h and GateSequence.h. Patterns have up to
+   SEQUENCER_MAX_STEPS steps.
+
+   The caller provides the storage of each sequencer; the library never
+   allocates. Functions that take parameters return 0, or -1 for
+   parameters out of range, which leave the sequencer unchanged.
+*/
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#define SEQUENCER_MAX_STEPS      32
+
+enum sequencer_mode {
+  SEQUENCER_DISABLED             =  0,
+  SEQUENCER_TRIGGERING           =  1,
+  SEQUENCER_ALTERNATING          =  2
+};
+
+/* opaque, may be copied, eg to save and restore a state */
+typedef struct sequencer {
+  uint64_t storage[3];
+} sequencer;
+
+/* the Euclidean pattern of fills in steps, step 0 in bit 0 */
+int sequencer_pattern(uint8_t steps, uint8_t fills, uint32_t* bits);
+
+/* a sequencer of one step with no fills, disabled, with the gate off */
+void sequencer_init(sequencer* seq);
+int sequencer_calculate(sequencer* seq, uint8_t steps, uint8_t fills);
+/* sets the offset of step 0, from 0 to 127 */
+int sequencer_rotate(sequencer* seq, int8_t offset);
+int sequencer_set_mode(sequencer* seq, enum sequencer_mode mode);
+
+/* clock edges and reset, return the gate */
+int sequencer_rise(sequencer* seq);
+int sequencer_fall(sequencer* seq);
+int sequencer_reset(sequencer* seq);
+
+void sequencer_seek(sequencer* seq, uint16_t step);
+int sequencer_peek(const sequencer* seq, uint16_t step);
+
+int sequencer_gate(const sequencer* seq);
+uint32_t sequencer_bits(const sequencer* seq);
+uint8_t sequencer_length(const sequencer* seq);
+uint8_t sequencer_position(const sequencer* seq);
+/* steps and full cycles played since the last reset or seek; the step
+   count wraps to 0 after 65536 steps and the cycle count with it */
+uint16_t sequencer_steps_played(const sequencer* seq);
+uint16_t sequencer_cycles_played(const sequencer* seq);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif /* _SEQUENCER_LIBRARY_H_ */
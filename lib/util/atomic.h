@@ -0,0 +1,14 @@
+#ifndef _LIB_UTIL_ATOMIC_H_
+#define _LIB_UTIL_ATOMIC_H_
+
+/**
+   <util/atomic.h> for the host library. There are no interrupts to
+   disable: a sequencer is not thread safe, and callers that share one
+   between threads lock around it.
+*/
+
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_FORCEON
+#define ATOMIC_BLOCK(type) for(bool lib_atomic = true; lib_atomic; lib_atomic = false)
+
+#endif /* _LIB_UTIL_ATOMIC_H_ */
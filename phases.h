@@ -0,0 +1,45 @@
+/* generated by sim/phases from bjorklund.h - do not edit */
+#ifndef _PHASES_H_
+#define _PHASES_H_
+
+#define EUCLIDEAN_PHASES_STEPS 32
+#define EUCLIDEAN_PHASES_SIZE 561
+
+/* the phase of E(k,n) is at n * (n + 1) / 2 + k */
+const uint8_t euclideanPhases[EUCLIDEAN_PHASES_SIZE] PROGMEM = {
+  0, // n = 0
+   0,  0, // n = 1
+   0,  1,  0, // n = 2
+   0,  1,  1,  0, // n = 3
+   0,  1,  2,  2,  0, // n = 4
+   0,  1,  4,  0,  3,  0, // n = 5
+   0,  1,  2,  3,  2,  4,  0, // n = 6
+   0,  1,  4,  6,  0,  2,  5,  0, // n = 7
+   0,  1,  2,  5,  4,  2,  4,  6,  0, // n = 8
+   0,  1,  4,  3,  8,  0,  3,  4,  7,  0, // n = 9
+   0,  1,  2,  6,  8,  5,  0,  3,  6,  8,  0, // n = 10
+   0,  1,  4,  5,  7, 10,  0,  3,  5,  6,  9,  0, // n = 11
+   0,  1,  2,  3,  4,  9,  6,  2,  4,  6,  8, 10,  0, // n = 12
+   0,  1,  4,  6,  8, 10, 12,  0,  2,  4,  6,  8, 11,  0, // n = 13
+   0,  1,  2,  5,  8,  9, 12,  7,  0,  4,  4,  8, 10, 12,  0, // n = 14
+   0,  1,  4,  3,  7,  5, 12, 14,  0,  0,  5,  7,  9, 10, 13,  0, // n = 15
+   0,  1,  2,  6,  4, 10, 10, 13,  8,  2,  4,  5,  8,  9, 12, 14,  0, // n = 16
+   0,  1,  4,  5,  8,  9, 11, 13, 16,  0,  3,  5,  7,  8, 11, 12, 15,  0, // n = 17
+   0,  1,  2,  3,  8, 10,  6, 14, 16,  9,  0,  3,  6,  7,  8, 12, 14, 16,  0, // n = 18
+   0,  1,  4,  6,  7,  9, 12, 14, 16, 18,  0,  2,  4,  6,  9, 11, 12, 14, 17,  0, // n = 19
+   0,  1,  2,  5,  4,  5, 12, 13, 16, 17, 10,  2,  0,  6,  6, 10, 12, 14, 16, 18,  0, // n = 20
+   0,  1,  4,  3,  8, 10, 12,  7, 15, 18, 20,  0,  0,  5,  7,  6, 10, 12, 15, 16, 19,  0, // n = 21
+   0,  1,  2,  6,  8,  9, 10, 14, 14, 17, 20, 11,  0,  4,  6,  7, 10, 12, 12, 15, 18, 20,  0, // n = 22
+   0,  1,  4,  5,  7, 10, 11, 13, 15, 18, 19, 22,  0,  3,  4,  7,  9, 11, 12, 15, 17, 18, 21,  0, // n = 23
+   0,  1,  2,  3,  4,  9,  6, 13,  8, 15, 18, 21, 12,  2,  4,  6,  8, 10, 12, 14, 16, 18, 20, 22,  0, // n = 24
+   0,  1,  4,  6,  8,  5, 12, 14, 16, 18, 20, 22, 24,  0,  2,  0,  6,  8, 10, 12, 15, 16, 18, 20, 23,  0, // n = 25
+   0,  1,  2,  5,  8, 10, 12, 14, 16, 17, 20, 22, 24, 13,  0,  3,  4,  8,  8, 11, 12, 15, 16, 20, 22, 24,  0, // n = 26
+   0,  1,  4,  3,  7,  9, 12, 13, 16,  9, 20, 21, 24, 26,  0,  0,  5,  6,  9, 10, 13, 12, 17, 19, 21, 22, 25,  0, // n = 27
+   0,  1,  2,  6,  4, 10, 10,  7, 16, 18, 18, 22, 24, 25, 14,  2,  0,  5,  8,  9,  8, 14, 16, 17, 20, 21, 24, 26,  0, // n = 28
+   0,  1,  4,  5,  8,  9, 11, 14, 15, 17, 19, 21, 24, 25, 28,  0,  3,  4,  7,  9, 11, 13, 14, 17, 19, 20, 23, 24, 27,  0, // n = 29
+   0,  1,  2,  3,  8,  5,  6, 13, 14, 18, 10, 21, 24, 25, 28, 15,  0,  4,  0,  8, 10,  9, 14, 16, 18, 20, 20, 24, 26, 28,  0, // n = 30
+   0,  1,  4,  6,  7, 10, 12, 13, 15, 17, 20, 22, 23, 25, 28, 30,  0,  2,  5,  7,  8, 10, 13, 15, 17, 18, 20, 23, 24, 26, 29,  0, // n = 31
+   0,  1,  2,  5,  4,  9, 12, 14,  8, 18, 20, 21, 20, 25, 26, 29, 16,  2,  4,  6,  8, 10, 10, 13, 16, 17, 18, 22, 24, 26, 28, 30,  0, // n = 32
+};
+
+#endif /* _PHASES_H_ */
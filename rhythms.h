@@ -0,0 +1,46 @@
+/* generated by rhythms.py from patterns.txt - do not edit */
+#ifndef _RHYTHMS_H_
+#define _RHYTHMS_H_
+
+#define RHYTHM_CATALOGUE_SIZE 35
+#define RHYTHM_CATALOGUE_SIZE_16 31
+
+const Rhythm rhythms[RHYTHM_CATALOGUE_SIZE] PROGMEM = {
+  {  3,  2, 0x00000005UL }, // E(2,3) [x.x] onset 1: a common Afro-Cuban drum pattern
+  {  4,  3, 0x0000000dUL }, // E(3,4) [x.xx] onset 1: the archetypal pattern of the Cumbia from Colombia
+  {  5,  2, 0x00000005UL }, // E(2,5) [x.x..] onset 1: a thirteenth century Persian rhythm called Khafif-e-ramal
+  {  5,  2, 0x00000009UL }, // E(2,5) [x..x.] onset 2: the metric pattern of Dave Brubeck's Take Five
+  {  5,  3, 0x00000015UL }, // E(3,5) [x.x.x] onset 1
+  {  5,  3, 0x0000000dUL }, // E(3,5) [x.xx.] onset 2: another thirteenth century Persian rhythm by the name of
+  {  6,  5, 0x0000003dUL }, // E(5,6) [x.xxxx] onset 1
+  {  6,  5, 0x0000001fUL }, // E(5,6) [xxxxx.] onset 2: the York-Samai pattern
+  {  7,  3, 0x00000015UL }, // E(3,7) [x.x.x..] onset 1: a Ruchenitza rhythm used in a Bulgarian folk-dance
+  {  7,  4, 0x00000055UL }, // E(4,7) [x.x.x.x] onset 1: another Ruchenitza Bulgarian folk-dance rhythm
+  {  7,  5, 0x0000006dUL }, // E(5,7) [x.xx.xx] onset 1: the Nawakhat pattern
+  {  8,  3, 0x00000049UL }, // E(3,8) [x..x..x.] onset 1: the Cuban tresillo pattern discussed in the preceding
+  {  8,  5, 0x0000006dUL }, // E(5,8) [x.xx.xx.] onset 1: the Cuban cinquillo pattern discussed in the preceding
+  {  8,  5, 0x0000005bUL }, // E(5,8) [xx.xx.x.] onset 2: the Spanish Tango and a thirteenth century Persian rhythm
+  {  8,  7, 0x000000fdUL }, // E(7,8) [x.xxxxxx] onset 1: a typical rhythm played on the Bendir (frame drum)
+  {  9,  4, 0x00000055UL }, // E(4,9) [x.x.x.x..] onset 1: the Aksak rhythm of Turkey
+  {  9,  5, 0x00000155UL }, // E(5,9) [x.x.x.x.x] onset 1: a popular Arab rhythm called Agsag-Samai
+  {  9,  5, 0x000000d5UL }, // E(5,9) [x.x.x.xx.] onset 2: a drum pattern used by the Venda in South Africa
+  { 11,  4, 0x00000249UL }, // E(4,11) [x..x..x..x.] onset 1: the metric pattern used by Frank Zappa in his piece titled
+  { 11,  5, 0x00000155UL }, // E(5,11) [x.x.x.x.x..] onset 1: the metric pattern used by Moussorgsky in Pictures at an
+  { 12,  4, 0x00000249UL }, // E(4,12) [x..x..x..x..] onset 1: which is periodic with four repetitions of E(1
+  { 12,  5, 0x00000529UL }, // E(5,12) [x..x.x..x.x.] onset 1: the Venda clapping pattern of a South African children's
+  { 12,  7, 0x000005adUL }, // E(7,12) [x.xx.x.xx.x.] onset 1: a common West African bell pattern
+  { 16,  5, 0x00001249UL }, // E(5,16) [x..x..x..x..x...] onset 1: the Bossa-Nova rhythm necklace of Brazil
+  { 16,  5, 0x00002449UL }, // E(5,16) [x..x..x...x..x..] onset 3: the actual Bossa-Nova rhythm
+  { 16,  7, 0x000054a9UL }, // E(7,16) [x..x.x.x..x.x.x.] onset 1: a Samba rhythm necklace from Brazil
+  { 16,  7, 0x00002a55UL }, // E(7,16) [x.x.x.x..x.x.x..] onset 5: a clapping pattern from Ghana
+  { 16,  7, 0x000052a5UL }, // E(7,16) [x.x..x.x.x..x.x.] onset 7: the actual Samba rhythm
+  { 16,  9, 0x000056adUL }, // E(9,16) [x.xx.x.x.xx.x.x.] onset 1: a rhythm necklace used in the Central African Republic
+  { 16,  9, 0x00006ab5UL }, // E(9,16) [x.x.xx.x.x.x.xx.] onset 4: a rhythm played in West and Central Africa
+  { 16,  9, 0x00006ad5UL }, // E(9,16) [x.x.x.xx.x.x.xx.] onset 8: the bell pattern of the Ngbaka-Maibo rhythms of the Central
+  { 24, 11, 0x00554aa9UL }, // E(11,24) [x..x.x.x.x.x..x.x.x.x.x.] onset 1: a rhythm necklace of the Aka Pygmies of Central Africa
+  { 24, 11, 0x002aa555UL }, // E(11,24) [x.x.x.x.x.x..x.x.x.x.x..] onset 7: a rhythm necklace of the Aka Pygmies of Central Africa
+  { 24, 13, 0x00556aadUL }, // E(13,24) [x.xx.x.x.x.x.xx.x.x.x.x.] onset 1: another rhythm necklace of the Aka Pygmies of the upper
+  { 24, 13, 0x006aab55UL }, // E(13,24) [x.x.x.x.xx.x.x.x.x.x.xx.] onset 4: another rhythm necklace of the Aka Pygmies of the upper
+};
+
+#endif /* _RHYTHMS_H_ */
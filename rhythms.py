@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+"""
+Generates rhythms.h, a table of the named Euclidean rhythms documented in
+patterns.txt, for use by the firmware rhythm catalogue.
+
+Every E(k,n) pattern becomes one entry, and every mention of the rhythm
+being started on another onset ("when started on the second onset")
+becomes an additional entry with the pattern rotated to that onset.
+Entries are sorted by number of steps, so that builds with fewer steps
+can use a prefix of the table.
+
+usage: rhythms.py patterns.txt > rhythms.h
+"""
+
+import re
+import sys
+
+ORDINALS = {
+    'first': 1, 'second': 2, 'third': 3, 'fourth': 4, 'fifth': 5,
+    'sixth': 6, 'seventh': 7, 'eighth': 8, 'ninth': 9,
+}
+
+PATTERN = re.compile(r'^E\((\d+),\s*(\d+)\)\s*=\s*\[([x.\s]+)\]')
+ONSET = re.compile(r'on the (\w+) onset')
+ONSET_CLAUSE = re.compile(r'(when )?(it is |E\(\d+,\s*\d+\) is )?(usually )?(obtained by )?'
+                          r'(started|starts|starting)( E\(\d+,\s*\d+\))? on the \w+ onset'
+                          r'( as follows:)?', re.IGNORECASE)
+BRACKETS = re.compile(r'\(?\[[x.\s]*\]\)?')
+
+
+def parse(lines):
+    """Returns a list of (fills, steps, onset, pattern, description)."""
+    entries = []
+    current = None
+    for line in lines:
+        line = line.strip()
+        match = PATTERN.match(line)
+        if match:
+            fills, steps = int(match.group(1)), int(match.group(2))
+            pattern = match.group(3).replace(' ', '')
+            if len(pattern) != steps or pattern.count('x') != fills:
+                sys.exit('bad pattern: ' + line)
+            current = (fills, steps, pattern)
+            entries.append((fills, steps, 1, pattern, ''))
+            continue
+        if current is None or not line:
+            continue
+        fills, steps, pattern = current
+        # a rhythm named only when started on another onset leaves the
+        # description of the first onset empty
+        if not entries[-1][4] and not ONSET.search(sentences(line)[0]):
+            entries[-1] = entries[-1][:4] + (describe(line),)
+        for word in ONSET.findall(line):
+            if word == 'last':
+                onset = fills
+            elif word == 'penultimate':
+                onset = fills - 1
+            elif word in ORDINALS:
+                onset = ORDINALS[word]
+            else:
+                continue
+            entries.append((fills, steps, onset, rotate(pattern, onset),
+                            describe_onset(line, word)))
+        current = None if line.startswith('From ') else current
+    return entries
+
+
+def sentences(line):
+    return re.split(r'(?<=\.)\s+(?=[A-Z])', line)
+
+
+def describe_onset(line, word):
+    """Describes a rhythm by the sentence that names its onset, or by the
+    first sentence if that one only says where it usually starts."""
+    sentence = [s for s in sentences(line) if 'on the %s onset' % word in s][0]
+    text = ONSET_CLAUSE.sub('', BRACKETS.sub('', sentence)).strip(' ,.')
+    for prefix in ('it is also ', 'it is ', 'It is'):
+        if text.startswith(prefix):
+            text = text[len(prefix):].lstrip(' ,')
+    if text.endswith(' is'):
+        text = text[:-3]
+    if text.startswith('The '):
+        text = 't' + text[1:]
+    return describe(text if text else ONSET_CLAUSE.sub('', line))
+
+
+def describe(line):
+    text = line.lstrip(', ')
+    text = text.split('.')[0].split(',')[0]
+    for prefix in ('is ', 'yields '):
+        if text.startswith(prefix):
+            text = text[len(prefix):]
+    text = text.replace('\u2019', "'").encode('ascii', 'replace').decode()
+    while len(text) > 60:
+        text = text.rsplit(' ', 1)[0]
+    if text.endswith(' as well as'):
+        text = text[:-len(' as well as')]
+    return text
+
+
+def rotate(pattern, onset):
+    """Rotates the pattern so that it starts on the given (1-based) onset."""
+    onsets = [i for i, c in enumerate(pattern) if c == 'x']
+    start = onsets[onset - 1]
+    return pattern[start:] + pattern[:start]
+
+
+def bits(pattern):
+    value = 0
+    for i, c in enumerate(pattern):
+        if c == 'x':
+            value |= 1 << i
+    return value
+
+
+def main():
+    with open(sys.argv[1]) as f:
+        entries = parse(f)
+    entries.sort(key=lambda e: (e[1], e[0], e[2]))
+    print('/* generated by rhythms.py from patterns.txt - do not edit */')
+    print('#ifndef _RHYTHMS_H_')
+    print('#define _RHYTHMS_H_')
+    print()
+    print('#define RHYTHM_CATALOGUE_SIZE %d' % len(entries))
+    print('#define RHYTHM_CATALOGUE_SIZE_16 %d' % len([e for e in entries if e[1] <= 16]))
+    print()
+    print('const Rhythm rhythms[RHYTHM_CATALOGUE_SIZE] PROGMEM = {')
+    for fills, steps, onset, pattern, text in entries:
+        print('  { %2d, %2d, 0x%08xUL }, // E(%d,%d) [%s] onset %d%s' %
+              (steps, fills, bits(pattern), fills, steps, pattern, onset,
+               ': ' + text if text else ''))
+    print('};')
+    print()
+    print('#endif /* _RHYTHMS_H_ */')
+
+
+if __name__ == '__main__':
+    main()
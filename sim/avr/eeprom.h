@@ -0,0 +1,18 @@
+#ifndef _SIM_AVR_EEPROM_H_
+#define _SIM_AVR_EEPROM_H_
+
+/* Host replacement for <avr/eeprom.h>, backed by the simulated EEPROM */
+
+#include <stddef.h>
+#include <string.h>
+#include "sim.h"
+
+inline uint8_t eeprom_read_byte(const uint8_t* addr){
+  return sim_eeprom.bytes[(uintptr_t)addr];
+}
+
+inline void eeprom_read_block(void* dst, const void* src, size_t n){
+  memcpy(dst, sim_eeprom.bytes + (uintptr_t)src, n);
+}
+
+#endif /* _SIM_AVR_EEPROM_H_ */
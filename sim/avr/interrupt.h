@@ -0,0 +1,24 @@
+#ifndef _SIM_AVR_INTERRUPT_H_
+#define _SIM_AVR_INTERRUPT_H_
+
+/**
+   Host replacement for <avr/interrupt.h>.
+   Interrupt handlers become ordinary functions that the simulation calls
+   when the corresponding interrupt is enabled and pending.
+*/
+
+#include "sim.h"
+
+#define ISR(vector) void vector()
+#define SIGNAL(vector) ISR(vector)
+
+#define cli() sim_cli()
+#define sei() sim_sei()
+
+void INT0_vect();
+void INT1_vect();
+void TIMER1_OVF_vect();
+void ADC_vect();
+void EE_READY_vect();
+
+#endif /* _SIM_AVR_INTERRUPT_H_ */
@@ -0,0 +1,108 @@
+#ifndef _SIM_AVR_IO_H_
+#define _SIM_AVR_IO_H_
+
+/**
+   Host replacement for <avr/io.h>, used to build the firmware natively.
+   Port, data direction and peripheral registers are plain variables.
+   PINx reads back the output bits from PORTx and the input bits from the
+   levels driven by the simulation; writing PINx sets those input levels.
+   Only the registers and bits used by this firmware are defined.
+*/
+
+#include <inttypes.h>
+#include "sim.h"
+
+#define _BV(bit) (1 << (bit))
+#define _SFR_BYTE(sfr) (sfr)
+
+#define PORTB     (sim_portB.port)
+#define DDRB      (sim_portB.ddr)
+#define PINB      (sim_portB.pin)
+#define PORTC     (sim_portC.port)
+#define DDRC      (sim_portC.ddr)
+#define PINC      (sim_portC.pin)
+#define PORTD     (sim_portD.port)
+#define DDRD      (sim_portD.ddr)
+#define PIND      (sim_portD.pin)
+
+#define PORTB0    0
+#define PORTB1    1
+#define PORTB2    2
+#define PORTB3    3
+#define PORTB4    4
+#define PORTB5    5
+#define PORTB6    6
+#define PORTB7    7
+#define PORTC0    0
+#define PORTC1    1
+#define PORTC2    2
+#define PORTC3    3
+#define PORTC4    4
+#define PORTC5    5
+#define PORTC6    6
+#define PORTD0    0
+#define PORTD1    1
+#define PORTD2    2
+#define PORTD3    3
+#define PORTD4    4
+#define PORTD5    5
+#define PORTD6    6
+#define PORTD7    7
+
+/* external interrupts */
+#define EICRA     sim_EICRA
+#define EIMSK     sim_EIMSK
+#define EIFR      sim_EIFR
+#define ISC00     0
+#define ISC01     1
+#define ISC10     2
+#define ISC11     3
+#define INT0      0
+#define INT1      1
+#define INTF0     0
+#define INTF1     1
+
+/* analog to digital converter */
+#define ADMUX     sim_ADMUX
+#define ADCSRA    sim_ADCSRA
+#define ADCL      sim_ADCL
+#define ADCH      sim_ADCH
+#define MUX0      0
+#define MUX1      1
+#define MUX2      2
+#define MUX3      3
+#define ADLAR     5
+#define REFS0     6
+#define REFS1     7
+#define ADPS0     0
+#define ADPS1     1
+#define ADPS2     2
+#define ADIE      3
+#define ADIF      4
+#define ADATE     5
+#define ADSC      6
+#define ADEN      7
+
+/* EEPROM */
+#define E2END     (SIM_EEPROM_SIZE-1)
+#define EECR      sim_EECR
+#define EEDR      sim_EEDR
+#define EEAR      sim_EEAR
+#define EERE      0
+#define EEPE      1
+#define EEMPE     2
+#define EERIE     3
+
+/* 16-bit timer */
+#define TCCR1A    sim_TCCR1A
+#define TCCR1B    sim_TCCR1B
+#define TCNT1     sim_TCNT1
+#define TIMSK1    sim_TIMSK1
+#define TIFR1     sim_TIFR1
+#define CS10      0
+#define CS11      1
+#define CS12      2
+#define TOIE1     0
+#define TOV1      0
+
+#endif /* _SIM_AVR_IO_H_ */
@@ -0,0 +1,14 @@
+#ifndef _SIM_AVR_PGMSPACE_H_
+#define _SIM_AVR_PGMSPACE_H_
+
+/* Host replacement for <avr/pgmspace.h>: program memory is ordinary memory */
+
+#include <inttypes.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+
+#endif /* _SIM_AVR_PGMSPACE_H_ */
@@ -0,0 +1,89 @@
+/*
+  Builds a pattern bank (see PatternBank.h) from render configuration
+  lines (see render.h), whose outputs, tempos and bars are ignored, or
+  prints a bank as bank.h, the array that a firmware build with
+  SEQUENCER_PATTERN_BANK flashes to program memory. The module plays
+  the steps, pattern and rotation of each entry, but its switches set
+  the modes and chaining, so bank.h is only written for banks with the
+  same modes and chaining in every entry, and prints their settings.
+
+  usage: bank configs.txt out.bank
+         bank -c in.bank > bank.h
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "render.h"
+#include "lib/PatternBankFile.h"
+
+int progmem(const char* file){
+  FILE* in = fopen(file, "rb");
+  std::vector<uint8_t> bank;
+  if(in){
+    uint8_t buf[4096];
+    size_t n;
+    while((n = fread(buf, 1, sizeof(buf), in)) > 0)
+      bank.insert(bank.end(), buf, buf + n);
+    fclose(in);
+  }
+  if(bank.empty() || !PatternBank(&bank[0]).check(bank.size())){
+    fprintf(stderr, "%s: not a pattern bank\n", file);
+    return 1;
+  }
+  uint32_t entry;
+  RenderConfig config;
+  if(!renderModuleBank(PatternBank(&bank[0]), entry, config)){
+    if(!PatternBank(&bank[0]).getEntries())
+      fprintf(stderr, "%s: no entries\n", file);
+    else
+      fprintf(stderr, "%s: entry %" PRIu32 " needs another setting of the switches "
+	      "or more than %d steps\n", file, entry, SEQUENCER_STEPS_RANGE);
+    return 1;
+  }
+  static const char* modes[] = { "disabled", "triggering", "alternating" };
+  fprintf(stderr, "%s: set A %s, B %s, %s\n", file, modes[config.mode[0]], modes[config.mode[1]],
+	  config.chained ? "chained" : "normal");
+  return PatternBankBuilder::writeProgmem(bank, stdout) ? 0 : 1;
+}
+
+int main(int argc, char** argv){
+  if(argc == 3 && !strcmp(argv[1], "-c"))
+    return progmem(argv[2]);
+  if(argc != 3){
+    fprintf(stderr, "usage: %s configs.txt out.bank\n       %s -c in.bank > bank.h\n", argv[0], argv[0]);
+    return 1;
+  }
+  FILE* in = strcmp(argv[1], "-") ? fopen(argv[1], "r") : stdin;
+  if(!in){
+    perror(argv[1]);
+    return 1;
+  }
+  PatternBankBuilder builder;
+  char line[4096];
+  for(unsigned n=1; fgets(line, sizeof(line), in); ++n){
+    const char* p = line + strspn(line, " \t\r\n");
+    if(!*p || *p == '#')
+      continue;
+    RenderConfig config;
+    uint32_t bits[RENDER_CHANNELS];
+    if(!renderParse(p, config)){
+      fprintf(stderr, "%s:%u: invalid configuration\n", argv[1], n);
+      return 1;
+    }
+    if(!builder.add(renderBankEntry(config, bits), bits)){
+      fprintf(stderr, "%s:%u: too many distinct patterns\n", argv[1], n);
+      return 1;
+    }
+  }
+  if(in != stdin)
+    fclose(in);
+  std::vector<uint8_t> bank = builder.build();
+  if(!PatternBankBuilder::write(bank, argv[2])){
+    perror(argv[2]);
+    return 1;
+  }
+  printf("%s: %lu entries, %lu bytes\n", argv[2], (unsigned long)builder.getEntries(),
+	 (unsigned long)bank.size());
+  return 0;
+}
@@ -0,0 +1,155 @@
+#ifndef _BENCHMARK_H_
+#define _BENCHMARK_H_
+
+/**
+   Minimal host benchmark harness.
+   Each benchmark is calibrated to run for about BENCHMARK_TARGET_NS per
+   repetition, repeated BENCHMARK_REPETITIONS times, and reported as the
+   median, minimum and standard deviation of the time per operation.
+   Retired instructions per operation are counted with perf_event_open
+   where the kernel allows it, otherwise they are reported as unknown.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <algorithm>
+#include <vector>
+#include <string>
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#define BENCHMARK_REPETITIONS    7
+#define BENCHMARK_TARGET_NS      2000000
+
+struct BenchmarkResult {
+  std::string name;
+  uint64_t iterations;
+  double median;
+  double min;
+  double stddev;
+  double instructions; // negative if not available
+};
+
+class Benchmark {
+public:
+  Benchmark() : counter(-1) {
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    counter = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+  }
+
+  ~Benchmark(){
+    if(counter >= 0)
+      close(counter);
+  }
+
+  /* op(n) must perform n operations */
+  template<typename Op>
+  void run(const std::string& name, Op op){
+    uint64_t n = 1;
+    while(time(op, n) < BENCHMARK_TARGET_NS/10 && n < (1ULL << 40))
+      n *= 10;
+    n = std::max<uint64_t>(1, n * BENCHMARK_TARGET_NS / std::max<double>(1, time(op, n)));
+    std::vector<double> samples;
+    double instructions = -1;
+    for(int i=0; i<BENCHMARK_REPETITIONS; ++i){
+      startCounter();
+      samples.push_back(time(op, n) / n);
+      double count = stopCounter();
+      if(count >= 0 && (instructions < 0 || count / n < instructions))
+	instructions = count / n;
+    }
+    std::sort(samples.begin(), samples.end());
+    double mean = 0, variance = 0;
+    for(size_t i=0; i<samples.size(); ++i)
+      mean += samples[i] / samples.size();
+    for(size_t i=0; i<samples.size(); ++i)
+      variance += (samples[i] - mean) * (samples[i] - mean) / samples.size();
+    BenchmarkResult result = { name, n, samples[samples.size()/2], samples[0],
+			       sqrt(variance), instructions };
+    results.push_back(result);
+    if(instructions >= 0)
+      printf("%-40s %10.2f ns/op %10.1f instructions/op (min %.2f, stddev %.2f)\n",
+	     name.c_str(), result.median, instructions, result.min, result.stddev);
+    else
+      printf("%-40s %10.2f ns/op (min %.2f, stddev %.2f)\n",
+	     name.c_str(), result.median, result.min, result.stddev);
+  }
+
+  const std::vector<BenchmarkResult>& getResults() const {
+    return results;
+  }
+
+  void writeJson(FILE* out){
+    fprintf(out, "{\n  \"benchmarks\": [\n");
+    for(size_t i=0; i<results.size(); ++i){
+      const BenchmarkResult& r = results[i];
+      fprintf(out, "    { \"name\": \"%s\", \"iterations\": %" PRIu64
+	      ", \"ns_per_op\": %.3f, \"ns_min\": %.3f, \"ns_stddev\": %.3f, \"instructions_per_op\": ",
+	      r.name.c_str(), r.iterations, r.median, r.min, r.stddev);
+      if(r.instructions >= 0)
+	fprintf(out, "%.1f }", r.instructions);
+      else
+	fprintf(out, "null }");
+      fprintf(out, i+1 < results.size() ? ",\n" : "\n");
+    }
+    fprintf(out, "  ]\n}\n");
+  }
+
+private:
+  template<typename Op>
+  static double time(Op& op, uint64_t n){
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    op(n);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+  }
+
+  void startCounter(){
+#ifdef __linux__
+    if(counter >= 0){
+      ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+      ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  double stopCounter(){
+#ifdef __linux__
+    uint64_t count;
+    if(counter >= 0){
+      ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+      if(read(counter, &count, sizeof(count)) == sizeof(count))
+	return count;
+    }
+#endif
+    return -1;
+  }
+
+  int counter;
+  std::vector<BenchmarkResult> results;
+};
+
+/* keeps the compiler from optimising away a computed value */
+template<typename T>
+inline void benchmarkKeep(const T& value){
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+#endif /* _BENCHMARK_H_ */
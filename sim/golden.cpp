@@ -0,0 +1,22 @@
+/*
+  Writes the golden pattern corpus checked by GoldenPatternTest.
+  Only regenerate it when a change in behaviour is intended.
+
+  usage: golden [file]
+*/
+
+#include <stdio.h>
+#include "golden.h"
+
+int main(int argc, char** argv){
+  const char* file = argc > 1 ? argv[1] : "golden.bin";
+  std::vector<uint8_t> corpus = goldenCorpus();
+  FILE* out = fopen(file, "wb");
+  if(!out || fwrite(&corpus[0], 1, corpus.size(), out) != corpus.size()){
+    perror(file);
+    return 1;
+  }
+  fclose(out);
+  printf("%s: %lu bytes\n", file, (unsigned long)corpus.size());
+  return 0;
+}
@@ -0,0 +1,115 @@
+#ifndef _GOLDEN_H_
+#define _GOLDEN_H_
+
+/**
+   Golden pattern corpus: every Euclidean pattern of up to GOLDEN_MAX_STEPS
+   steps, with the gate output it produces at every rotation and in every
+   GateSequencer mode.
+
+   File layout, after an 8 byte header ("EUCL", version, max steps, 0, 0),
+   for each number of steps n from 1 to GOLDEN_MAX_STEPS:
+     for each number of fills f from 0 to n:
+       the pattern word, little endian, in (n+7)/8 bytes
+       for each rotation r from 0 to n-1, and each mode:
+         the gate output after each rise and each fall over two cycles,
+         starting from reset, as 4n bits packed into (n+1)/2 bytes
+*/
+
+#include <inttypes.h>
+#include <string.h>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <avr/io.h>
+#include "device.h"
+
+#undef SEQUENCER_BITS_TYPE
+#define SEQUENCER_BITS_TYPE uint32_t
+#include "GateSequencer.h"
+
+#define GOLDEN_VERSION       1
+#define GOLDEN_MAX_STEPS     32
+#define GOLDEN_HEADER_SIZE   8
+#define GOLDEN_MODES         3
+
+inline size_t goldenBlockSize(uint8_t n){
+  return (n+1) * ((n+7)/8 + n * GOLDEN_MODES * ((n+1)/2));
+}
+
+inline void goldenHeader(std::vector<uint8_t>& out){
+  const uint8_t header[GOLDEN_HEADER_SIZE] = {
+    'E', 'U', 'C', 'L', GOLDEN_VERSION, GOLDEN_MAX_STEPS, 0, 0 };
+  size_t size = out.size();
+  out.resize(size + GOLDEN_HEADER_SIZE);
+  memcpy(&out[size], header, GOLDEN_HEADER_SIZE);
+}
+
+inline size_t goldenOffset(uint8_t n){
+  size_t offset = GOLDEN_HEADER_SIZE;
+  for(uint8_t i=1; i<n; ++i)
+    offset += goldenBlockSize(i);
+  return offset;
+}
+
+/* sets the mode switches of a sequencer and updates its mode */
+inline void goldenSetMode(GateSequencer& seq, uint8_t mode){
+  PIND |= _BV(SEQUENCER_TRIGGER_SWITCH_PIN_A) | _BV(SEQUENCER_ALTERNATE_SWITCH_PIN_A);
+  if(mode == GateSequencer::TRIGGERING)
+    PIND &= ~_BV(SEQUENCER_TRIGGER_SWITCH_PIN_A);
+  else if(mode == GateSequencer::ALTERNATING)
+    PIND &= ~_BV(SEQUENCER_ALTERNATE_SWITCH_PIN_A);
+  seq.recalculate = false;
+  seq.update();
+}
+
+/* appends the corpus block for n steps */
+inline void goldenBlock(uint8_t n, std::vector<uint8_t>& out){
+  GateSequencer seq(SEQUENCER_OUTPUT_PIN_A,
+		    SEQUENCER_TRIGGER_SWITCH_PIN_A,
+		    SEQUENCER_ALTERNATE_SWITCH_PIN_A,
+		    SEQUENCER_LED_A_PIN);
+  for(uint8_t f=0; f<=n; ++f){
+    seq.calculate(n, f);
+    for(uint8_t i=0; i<(n+7)/8; ++i)
+      out.push_back(seq.bits >> (i*8));
+    for(uint8_t r=0; r<n; ++r){
+      for(uint8_t mode=0; mode<GOLDEN_MODES; ++mode){
+	goldenSetMode(seq, mode);
+	seq.rotate(r);
+	seq.reset();
+	uint8_t gates[GOLDEN_MAX_STEPS/2] = {};
+	for(uint8_t i=0; i<4*n; i+=2){
+	  seq.rise();
+	  gates[i/8] |= seq.isOn() << (i%8);
+	  seq.fall();
+	  gates[i/8] |= seq.isOn() << (i%8+1);
+	}
+	out.insert(out.end(), gates, gates+(n+1)/2);
+      }
+    }
+  }
+}
+
+/* computes the whole corpus, one block per step count, on all cores */
+inline std::vector<uint8_t> goldenCorpus(){
+  std::vector<uint8_t> blocks[GOLDEN_MAX_STEPS+1];
+  std::atomic<int> next(GOLDEN_MAX_STEPS);
+  unsigned count = std::thread::hardware_concurrency();
+  std::vector<std::thread> threads;
+  for(unsigned t=0; t<(count ? count : 1); ++t){
+    threads.push_back(std::thread([&](){
+	  // largest blocks first
+	  for(int n; (n = next--) > 0; )
+	    goldenBlock(n, blocks[n]);
+	}));
+  }
+  for(size_t t=0; t<threads.size(); ++t)
+    threads[t].join();
+  std::vector<uint8_t> corpus;
+  goldenHeader(corpus);
+  for(int n=1; n<=GOLDEN_MAX_STEPS; ++n)
+    corpus.insert(corpus.end(), blocks[n].begin(), blocks[n].end());
+  return corpus;
+}
+
+#endif /* _GOLDEN_H_ */
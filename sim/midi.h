@@ -0,0 +1,113 @@
+#ifndef _MIDI_H_
+#define _MIDI_H_
+
+/**
+   Streaming writer for Standard MIDI Files of one track (format 0).
+   Events are written at non-decreasing ticks through a fixed buffer, so a
+   file of any length is written in constant memory; the track length in
+   the chunk header is filled in when the file is closed, which needs a
+   seekable file.
+*/
+
+#include <stdio.h>
+#include <inttypes.h>
+
+#define MIDI_BUFFER_SIZE         65536
+#define MIDI_TRACK_LENGTH_OFFSET 18
+
+class MidiWriter {
+public:
+  MidiWriter(FILE* f, uint16_t division) : out(f), used(0), length(0), time(0) {
+    const uint8_t header[] = {
+      'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1,
+      (uint8_t)(division >> 8), (uint8_t)division,
+      'M', 'T', 'r', 'k', 0, 0, 0, 0
+    };
+    for(uint8_t b : header)
+      put(b);
+    length = 0;
+  }
+
+  ~MidiWriter(){
+    close();
+  }
+
+  /* microseconds per quarter note, from this tick on */
+  void tempo(uint32_t tick, uint32_t us){
+    event(tick);
+    put(0xff);
+    put(0x51);
+    put(3);
+    put(us >> 16);
+    put(us >> 8);
+    put(us);
+  }
+
+  void noteOn(uint32_t tick, uint8_t channel, uint8_t note, uint8_t velocity){
+    event(tick);
+    put(0x90 | channel);
+    put(note);
+    put(velocity);
+  }
+
+  void noteOff(uint32_t tick, uint8_t channel, uint8_t note){
+    event(tick);
+    put(0x80 | channel);
+    put(note);
+    put(0);
+  }
+
+  /* ends the track at a tick and fills in its length, false on a write error */
+  bool close(uint32_t tick = 0){
+    if(!out)
+      return true;
+    event(tick > time ? tick : time);
+    put(0xff);
+    put(0x2f);
+    put(0);
+    flush();
+    const uint8_t size[] = {
+      (uint8_t)(length >> 24), (uint8_t)(length >> 16), (uint8_t)(length >> 8), (uint8_t)length
+    };
+    bool ok = !ferror(out) && !fseek(out, MIDI_TRACK_LENGTH_OFFSET, SEEK_SET) &&
+      fwrite(size, 1, sizeof(size), out) == sizeof(size) && !fflush(out);
+    out = NULL;
+    return ok;
+  }
+
+private:
+  /* the delta time of the next event, as a variable length quantity */
+  void event(uint32_t tick){
+    uint32_t delta = tick - time;
+    time = tick;
+    uint8_t bytes[5];
+    uint8_t n = 0;
+    do {
+      bytes[n++] = delta & 0x7f;
+      delta >>= 7;
+    } while(delta);
+    while(n--)
+      put(bytes[n] | (n ? 0x80 : 0));
+  }
+
+  inline void put(uint8_t b){
+    if(used == MIDI_BUFFER_SIZE)
+      flush();
+    buffer[used++] = b;
+    length++;
+  }
+
+  void flush(){
+    if(used)
+      fwrite(buffer, 1, used, out);
+    used = 0;
+  }
+
+  FILE* out;
+  size_t used;
+  uint32_t length;
+  uint32_t time;
+  uint8_t buffer[MIDI_BUFFER_SIZE];
+};
+
+#endif /* _MIDI_H_ */
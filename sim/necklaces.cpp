@@ -0,0 +1,58 @@
+/*
+  Writes the necklace index of lib/NecklaceIndex.h, or looks gate
+  patterns up in it: each pattern is a string of steps, x or 1 for a
+  pulse and - or 0 for a gap, and prints the steps, fills and rotation
+  that play it from a reset.
+
+  usage: necklaces -o necklaces.bin
+         necklaces necklaces.bin pattern...
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "lib/NecklaceIndex.h"
+
+int main(int argc, char** argv){
+  if(argc == 3 && !strcmp(argv[1], "-o")){
+    std::vector<uint8_t> index = NecklaceIndex::build();
+    FILE* out = fopen(argv[2], "wb");
+    if(!out || fwrite(&index[0], 1, index.size(), out) != index.size() || fclose(out)){
+      perror(argv[2]);
+      return 1;
+    }
+    printf("%s: %lu bytes\n", argv[2], (unsigned long)index.size());
+    return 0;
+  }
+  if(argc < 3){
+    fprintf(stderr, "usage: %s -o necklaces.bin\n       %s necklaces.bin pattern...\n", argv[0], argv[0]);
+    return 1;
+  }
+  NecklaceIndex index;
+  if(!index.open(argv[1])){
+    fprintf(stderr, "%s: not a necklace index\n", argv[1]);
+    return 1;
+  }
+  int status = 0;
+  for(int i=2; i<argc; ++i){
+    size_t steps = strlen(argv[i]);
+    uint64_t pattern = 0;
+    bool valid = steps >= 1 && steps <= NECKLACE_MAX_STEPS;
+    for(size_t s=0; s<steps && valid; ++s){
+      char c = argv[i][s];
+      if(c == 'x' || c == '1')
+	pattern |= 1ULL << s;
+      else if(c != '-' && c != '0')
+	valid = false;
+    }
+    NecklaceMatch match;
+    if(!valid){
+      fprintf(stderr, "%s: invalid pattern\n", argv[i]);
+      status = 1;
+    }else if(index.lookup(pattern, steps, match)){
+      printf("%s steps %d fills %d rotation %d\n", argv[i], match.steps, match.fills, match.rotation);
+    }else{
+      printf("%s not euclidean\n", argv[i]);
+    }
+  }
+  return status;
+}
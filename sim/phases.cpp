@@ -0,0 +1,54 @@
+/*
+  Generates phases.h, the start phases of the Bresenham walk of
+  Bresenham.h: for every E(k,n) of up to 32 steps, the smallest phase
+  p such that step i of the Bjorklund pattern has a pulse if and only
+  if (p + i * k) mod n < k. Fails if a pattern has no such phase.
+
+  usage: phases > phases.h
+*/
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "bjorklund.h"
+
+#define PHASES_STEPS 32
+
+static uint32_t walk(uint8_t n, uint8_t k, uint8_t p){
+  uint32_t bits = 0;
+  for(uint8_t i=0; i<n; ++i){
+    if(p < k)
+      bits |= 1UL << i;
+    p += k;
+    if(p >= n)
+      p -= n;
+  }
+  return bits;
+}
+
+int main(){
+  printf("/* generated by sim/phases from bjorklund.h - do not edit */\n");
+  printf("#ifndef _PHASES_H_\n#define _PHASES_H_\n\n");
+  printf("#define EUCLIDEAN_PHASES_STEPS %d\n", PHASES_STEPS);
+  printf("#define EUCLIDEAN_PHASES_SIZE %d\n\n", (PHASES_STEPS + 1) * (PHASES_STEPS + 2) / 2);
+  printf("/* the phase of E(k,n) is at n * (n + 1) / 2 + k */\n");
+  printf("const uint8_t euclideanPhases[EUCLIDEAN_PHASES_SIZE] PROGMEM = {\n");
+  printf("  0, // n = 0\n");
+  for(uint8_t n=1; n<=PHASES_STEPS; ++n){
+    printf(" ");
+    for(uint8_t k=0; k<=n; ++k){
+      Bjorklund<uint32_t, 10> algo;
+      uint32_t bits = algo.compute(n, k);
+      uint8_t p = 0;
+      while(p < n && walk(n, k, p) != bits)
+	p++;
+      if(p == n){
+	fprintf(stderr, "E(%d,%d) has no start phase\n", k, n);
+	return 1;
+      }
+      printf(" %2d,", p);
+    }
+    printf(" // n = %d\n", n);
+  }
+  printf("};\n\n#endif /* _PHASES_H_ */\n");
+  return 0;
+}
@@ -0,0 +1,90 @@
+#ifndef _POOL_H_
+#define _POOL_H_
+
+/**
+   Work-stealing thread pool for batches of independent jobs of uneven
+   cost. run(count, job) calls job(i) once for each i below count: each
+   thread starts with an even share of the indices in its own deque and
+   takes from the back of it, and when it runs out steals from the front
+   of the others, so that the long jobs do not leave threads idle at the
+   end of a batch. The deques hold index ranges and each has its own lock,
+   which a job of any real size never contends for.
+*/
+
+#include <stddef.h>
+#include <thread>
+#include <mutex>
+#include <vector>
+
+class WorkStealingPool {
+public:
+  /* all cores for 0 */
+  WorkStealingPool(unsigned threads = 0) : count(threads) {
+    if(!count)
+      count = std::thread::hardware_concurrency();
+    if(!count)
+      count = 1;
+  }
+
+  unsigned size() const {
+    return count;
+  }
+
+  template<typename Job>
+  void run(size_t jobs, Job job){
+    std::vector<Deque> deques(count);
+    for(unsigned t=0; t<count; ++t){
+      deques[t].begin = jobs * t / count;
+      deques[t].end = jobs * (t+1) / count;
+    }
+    std::vector<std::thread> threads;
+    for(unsigned t=1; t<count; ++t)
+      threads.push_back(std::thread([&, t](){ work(deques, t, job); }));
+    work(deques, 0, job);
+    for(size_t t=0; t<threads.size(); ++t)
+      threads[t].join();
+  }
+
+private:
+  struct Deque {
+    std::mutex lock;
+    size_t begin, end;
+  };
+
+  template<typename Job>
+  void work(std::vector<Deque>& deques, unsigned self, Job& job){
+    size_t i;
+    while(true){
+      if(pop(deques[self], i)){
+	job(i);
+	continue;
+      }
+      bool stolen = false;
+      for(unsigned v=1; v<count && !stolen; ++v)
+	stolen = steal(deques[(self + v) % count], i);
+      if(!stolen)
+	return;
+      job(i);
+    }
+  }
+
+  static bool pop(Deque& d, size_t& i){
+    std::lock_guard<std::mutex> guard(d.lock);
+    if(d.begin == d.end)
+      return false;
+    i = --d.end;
+    return true;
+  }
+
+  static bool steal(Deque& d, size_t& i){
+    std::lock_guard<std::mutex> guard(d.lock);
+    if(d.begin == d.end)
+      return false;
+    i = d.begin++;
+    return true;
+  }
+
+  unsigned count;
+};
+
+#endif /* _POOL_H_ */
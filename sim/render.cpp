@@ -0,0 +1,121 @@
+/*
+  Renders Stoicheia configurations to Standard MIDI Files or CSV gate
+  timelines, with the firmware sequencers (see render.h), on a
+  work-stealing pool of threads. Configurations are read one per line
+  from the file, or standard input for -; empty lines and lines starting
+  with # are skipped. With -b the configurations are the entries of a
+  pattern bank (see PatternBank.h), rendered to files named by their
+  index, at the tempo and for the bars of -t and -n, as MIDI or CSV by
+  the extension of -x.
+
+  usage: render [-j threads] [-d output directory] configs.txt
+         render [-j threads] [-d output directory] -b [-t bpm] [-n bars] [-x mid|csv] bank
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <atomic>
+#include <vector>
+#include "render.h"
+#include "pool.h"
+#include "lib/PatternBankFile.h"
+
+/* reads configuration lines, false if the file cannot be read or has an invalid line */
+bool readConfigs(const char* file, std::vector<RenderConfig>& configs){
+  FILE* in = strcmp(file, "-") ? fopen(file, "r") : stdin;
+  if(!in){
+    perror(file);
+    return false;
+  }
+  char line[4096];
+  bool ok = true;
+  for(unsigned n=1; ok && fgets(line, sizeof(line), in); ++n){
+    const char* p = line + strspn(line, " \t\r\n");
+    if(!*p || *p == '#')
+      continue;
+    RenderConfig config;
+    if(!renderParse(p, config)){
+      fprintf(stderr, "%s:%u: invalid configuration\n", file, n);
+      ok = false;
+    }
+    configs.push_back(config);
+  }
+  if(in != stdin)
+    fclose(in);
+  return ok;
+}
+
+/* the entries of a bank, false if it cannot be read or an entry is out of range */
+bool readBank(const char* file, double bpm, unsigned bars, const std::string& extension,
+	      std::vector<RenderConfig>& configs){
+  PatternBankFile in;
+  if(!in.open(file)){
+    fprintf(stderr, "%s: not a pattern bank\n", file);
+    return false;
+  }
+  PatternBank bank = in.getBank();
+  configs.resize(bank.getEntries());
+  for(uint32_t i=0; i<bank.getEntries(); ++i){
+    if(!renderBankEntry(bank, i, configs[i])){
+      fprintf(stderr, "%s: entry %" PRIu32 " out of range\n", file, i);
+      return false;
+    }
+    configs[i].output = std::to_string(i) + "." + extension;
+    configs[i].bpm = bpm;
+    configs[i].bars = bars;
+  }
+  return true;
+}
+
+int main(int argc, char** argv){
+  unsigned threads = 0;
+  std::string dir;
+  const char* file = NULL;
+  bool bank = false;
+  double bpm = 120;
+  unsigned bars = 4;
+  std::string extension = "mid";
+  for(int i=1; i<argc; ++i){
+    if(!strcmp(argv[i], "-j") && i+1 < argc)
+      threads = strtoul(argv[++i], NULL, 0);
+    else if(!strcmp(argv[i], "-d") && i+1 < argc)
+      dir = argv[++i];
+    else if(!strcmp(argv[i], "-b"))
+      bank = true;
+    else if(!strcmp(argv[i], "-t") && i+1 < argc)
+      bpm = strtod(argv[++i], NULL);
+    else if(!strcmp(argv[i], "-n") && i+1 < argc)
+      bars = strtoul(argv[++i], NULL, 0);
+    else if(!strcmp(argv[i], "-x") && i+1 < argc)
+      extension = argv[++i];
+    else if(!file)
+      file = argv[i];
+    else
+      file = NULL, i = argc;
+  }
+  if(!file || bpm <= 0 || !bars){
+    fprintf(stderr, "usage: %s [-j threads] [-d output directory] configs.txt\n"
+	    "       %s [-j threads] [-d output directory] -b [-t bpm] [-n bars] [-x mid|csv] bank\n",
+	    argv[0], argv[0]);
+    return 1;
+  }
+  std::vector<RenderConfig> configs;
+  if(bank ? !readBank(file, bpm, bars, extension, configs) : !readConfigs(file, configs))
+    return 1;
+
+  WorkStealingPool pool(threads);
+  std::atomic<unsigned> failed(0);
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  pool.run(configs.size(), [&](size_t i){
+      if(!renderFile(configs[i], dir))
+	failed++;
+    });
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  printf("rendered %lu configurations on %u threads in %.3fs, %u failed\n",
+	 (unsigned long)configs.size(), pool.size(), elapsed, (unsigned)failed);
+  return failed ? 1 : 0;
+}
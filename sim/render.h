@@ -0,0 +1,274 @@
+#ifndef _RENDER_H_
+#define _RENDER_H_
+
+/**
+   Offline rendering of Stoicheia configurations to gate timelines. Each
+   configuration sets the steps, fills, rotation and mode of both channels
+   and the chained switch, as the knobs and switches would, and is played
+   by the firmware GateSequencer and ChainedSequencer on the simulated
+   ports of the rendering thread, from a reset, with a clock of sixteenth
+   notes at the given tempo.
+
+   A configuration is a line of
+     output stepsA fillsA rotationA modeA stepsB fillsB rotationB modeB chained bpm bars
+   with modes d(isabled), t(riggering) or a(lternating), chained 0 or 1,
+   and rotations from 0 to 15 as the knob sets them. Outputs ending in
+   .mid are Standard MIDI Files, with channel A on note 36 and channel B
+   on note 38 of MIDI channel 10, and anything else is a CSV timeline
+   with the gates after each clock edge that changes either of them.
+   The gates start off, as after a reset.
+
+   Configurations also come from the entries of a pattern bank (see
+   PatternBank.h), which carry the pattern word of each channel, so that
+   a bank plays as it would when flashed to the module.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <avr/io.h>
+#include "sim.h"
+#include "device.h"
+#include "GateSequencer.h"
+#include "ChainedSequencer.h"
+#include "PatternBank.h"
+#include "midi.h"
+
+#define RENDER_CHANNELS          2
+#define RENDER_STEPS_PER_BAR     16
+#define RENDER_DIVISION          96  // MIDI ticks per quarter note
+#define RENDER_TICKS_PER_STEP    (RENDER_DIVISION / 4)
+#define RENDER_MIDI_CHANNEL      9
+#define RENDER_VELOCITY          100
+#define RENDER_MAX_ROTATION      15
+
+static const uint8_t renderNotes[RENDER_CHANNELS] = { 36, 38 };
+
+struct RenderConfig {
+  std::string output;
+  uint8_t steps[RENDER_CHANNELS];
+  uint8_t fills[RENDER_CHANNELS];
+  uint8_t rotation[RENDER_CHANNELS];
+  SEQUENCER_BITS_TYPE bits[RENDER_CHANNELS];
+  GateSequencer::GateSequencerMode mode[RENDER_CHANNELS];
+  bool chained;
+  double bpm;
+  unsigned bars;
+};
+
+/* parses a configuration line, false if it is malformed or out of range */
+inline bool renderParse(const char* line, RenderConfig& config){
+  char output[1024];
+  unsigned steps[RENDER_CHANNELS], fills[RENDER_CHANNELS], rotation[RENDER_CHANNELS];
+  char mode[RENDER_CHANNELS];
+  unsigned chained;
+  if(sscanf(line, "%1023s %u %u %u %c %u %u %u %c %u %lf %u", output,
+	    &steps[0], &fills[0], &rotation[0], &mode[0],
+	    &steps[1], &fills[1], &rotation[1], &mode[1],
+	    &chained, &config.bpm, &config.bars) != 12)
+    return false;
+  config.output = output;
+  for(uint8_t c=0; c<RENDER_CHANNELS; ++c){
+    if(steps[c] < 1 || steps[c] > SEQUENCER_STEPS_RANGE || fills[c] > steps[c] ||
+       rotation[c] > RENDER_MAX_ROTATION)
+      return false;
+    config.steps[c] = steps[c];
+    config.fills[c] = fills[c];
+    config.rotation[c] = rotation[c];
+    Bjorklund<SEQUENCER_BITS_TYPE, SEQUENCE_ALGORITHM_ARRAY_SIZE> algo;
+    config.bits[c] = algo.compute(steps[c], fills[c]);
+    switch(mode[c]){
+    case 'd':
+      config.mode[c] = GateSequencer::DISABLED;
+      break;
+    case 't':
+      config.mode[c] = GateSequencer::TRIGGERING;
+      break;
+    case 'a':
+      config.mode[c] = GateSequencer::ALTERNATING;
+      break;
+    default:
+      return false;
+    }
+  }
+  config.chained = chained;
+  return chained <= 1 && config.bpm > 0 && config.bars > 0;
+}
+
+/* the configuration of a bank entry, false if it is out of range */
+inline bool renderBankEntry(const PatternBank& bank, uint32_t entry, RenderConfig& config){
+  for(uint8_t c=0; c<RENDER_CHANNELS; ++c){
+    uint8_t steps = bank.getSteps(entry, c);
+    uint32_t bits = bank.getBits(entry, c);
+    if(steps < 1 || steps > SEQUENCER_STEPS_RANGE || bank.getFills(entry, c) > steps ||
+       bank.getRotation(entry, c) > RENDER_MAX_ROTATION || bank.getMode(entry, c) > GateSequencer::ALTERNATING ||
+       bits >> (steps - 1) >> 1)
+      return false;
+    config.steps[c] = steps;
+    config.fills[c] = bank.getFills(entry, c);
+    config.rotation[c] = bank.getRotation(entry, c);
+    config.bits[c] = bits;
+    config.mode[c] = (GateSequencer::GateSequencerMode)bank.getMode(entry, c);
+  }
+  config.chained = bank.isChained(entry);
+  return true;
+}
+
+/* true if the module plays a bank as it renders: its switches set one
+   mode per channel and the chaining for every entry, and it has up to
+   SEQUENCER_STEPS_RANGE steps. Otherwise false, with the first entry it
+   cannot play, or the number of entries if the bank is empty. */
+inline bool renderModuleBank(const PatternBank& bank, uint32_t& entry, RenderConfig& first){
+  RenderConfig config;
+  for(entry=0; entry<bank.getEntries(); ++entry){
+    if(!renderBankEntry(bank, entry, entry ? config : first))
+      return false;
+    if(entry && (config.mode[0] != first.mode[0] || config.mode[1] != first.mode[1] ||
+		 config.chained != first.chained))
+      return false;
+  }
+  return entry > 0;
+}
+
+/* the bank entry of a configuration, with the pattern word of each channel in bits */
+inline PatternBankEntry renderBankEntry(const RenderConfig& config, uint32_t* bits){
+  PatternBankEntry entry = PatternBankEntry();
+  for(uint8_t c=0; c<RENDER_CHANNELS; ++c){
+    entry.channels[c].steps = config.steps[c];
+    entry.channels[c].fills = config.fills[c];
+    entry.channels[c].rotation = config.rotation[c];
+    entry.channels[c].mode = config.mode[c];
+    bits[c] = config.bits[c];
+  }
+  entry.flags = config.chained ? PATTERN_BANK_CHAINED : 0;
+  return entry;
+}
+
+class CsvWriter {
+public:
+  CsvWriter(FILE* f, double bpm) : out(f), seconds(60.0 / bpm / RENDER_DIVISION) {
+    fprintf(out, "tick,seconds,a,b\n");
+  }
+
+  void gates(uint32_t tick, const bool* on){
+    fprintf(out, "%" PRIu32 ",%.6f,%d,%d\n", tick, tick * seconds, on[0], on[1]);
+  }
+
+  bool close(uint32_t tick){
+    return !ferror(out);
+  }
+
+private:
+  FILE* out;
+  double seconds;
+};
+
+/* note on and off events for the gates that change */
+class MidiGateWriter {
+public:
+  MidiGateWriter(FILE* f, double bpm) : midi(f, RENDER_DIVISION) {
+    midi.tempo(0, 60000000.0 / bpm + 0.5);
+  }
+
+  void gates(uint32_t tick, const bool* on){
+    for(uint8_t c=0; c<RENDER_CHANNELS; ++c){
+      if(on[c] && !last[c])
+	midi.noteOn(tick, RENDER_MIDI_CHANNEL, renderNotes[c], RENDER_VELOCITY);
+      else if(!on[c] && last[c])
+	midi.noteOff(tick, RENDER_MIDI_CHANNEL, renderNotes[c]);
+      last[c] = on[c];
+    }
+  }
+
+  bool close(uint32_t tick){
+    bool off[RENDER_CHANNELS] = {};
+    gates(tick, off);
+    return midi.close(tick);
+  }
+
+private:
+  MidiWriter midi;
+  bool last[RENDER_CHANNELS] = {};
+};
+
+/* sets the mode switches of a channel and lets the sequencer read them */
+inline void renderSetMode(GateSequencer& seq, uint8_t trigger, uint8_t alternate,
+			  GateSequencer::GateSequencerMode mode){
+  SEQUENCER_TRIGGER_SWITCH_PINS |= _BV(trigger);
+  SEQUENCER_ALTERNATE_SWITCH_PINS |= _BV(alternate);
+  if(mode == GateSequencer::TRIGGERING)
+    SEQUENCER_TRIGGER_SWITCH_PINS &= ~_BV(trigger);
+  else if(mode == GateSequencer::ALTERNATING)
+    SEQUENCER_ALTERNATE_SWITCH_PINS &= ~_BV(alternate);
+  seq.recalculate = false;
+  seq.update();
+}
+
+/* plays a configuration into a writer, as the clock interrupt would */
+template<class Writer>
+bool renderConfig(const RenderConfig& config, Writer& writer){
+  sim_reset();
+  GateSequencer seqA(SEQUENCER_OUTPUT_PIN_A, SEQUENCER_TRIGGER_SWITCH_PIN_A,
+		     SEQUENCER_ALTERNATE_SWITCH_PIN_A, SEQUENCER_LED_A_PIN);
+  GateSequencer seqB(SEQUENCER_OUTPUT_PIN_B, SEQUENCER_TRIGGER_SWITCH_PIN_B,
+		     SEQUENCER_ALTERNATE_SWITCH_PIN_B, SEQUENCER_LED_B_PIN);
+  GateSequencer* channels[RENDER_CHANNELS] = { &seqA, &seqB };
+  const uint8_t order[] = { 0, 1 };
+  ChainedSequencer<RENDER_CHANNELS, sizeof(order)> combined(channels, order);
+  renderSetMode(seqA, SEQUENCER_TRIGGER_SWITCH_PIN_A, SEQUENCER_ALTERNATE_SWITCH_PIN_A, config.mode[0]);
+  renderSetMode(seqB, SEQUENCER_TRIGGER_SWITCH_PIN_B, SEQUENCER_ALTERNATE_SWITCH_PIN_B, config.mode[1]);
+  for(uint8_t c=0; c<RENDER_CHANNELS; ++c){
+    channels[c]->set(config.steps[c], config.bits[c]);
+    channels[c]->rotate(config.rotation[c]);
+    channels[c]->reset();
+  }
+  combined.reset();
+
+  // the gates are off after the reset
+  bool last[RENDER_CHANNELS] = { false, false };
+  uint32_t steps = config.bars * RENDER_STEPS_PER_BAR;
+  for(uint32_t i=0; i<2*steps; ++i){
+    bool high = !(i & 1);
+    if(config.chained)
+      high ? combined.rise() : combined.fall();
+    else if(high){
+      seqA.rise();
+      seqB.rise();
+    }else{
+      seqA.fall();
+      seqB.fall();
+    }
+    bool on[RENDER_CHANNELS] = { seqA.isOn(), seqB.isOn() };
+    if(on[0] != last[0] || on[1] != last[1])
+      writer.gates(i * RENDER_TICKS_PER_STEP / 2, on);
+    last[0] = on[0];
+    last[1] = on[1];
+  }
+  return writer.close(steps * RENDER_TICKS_PER_STEP);
+}
+
+/* renders a configuration to its output file, false on a write error */
+inline bool renderFile(const RenderConfig& config, const std::string& dir){
+  std::string path = dir.empty() ? config.output : dir + "/" + config.output;
+  FILE* out = fopen(path.c_str(), "wb");
+  if(!out){
+    perror(path.c_str());
+    return false;
+  }
+  bool ok;
+  size_t len = config.output.size();
+  if(len > 4 && !strcmp(config.output.c_str() + len - 4, ".mid")){
+    MidiGateWriter writer(out, config.bpm);
+    ok = renderConfig(config, writer);
+  }else{
+    CsvWriter writer(out, config.bpm);
+    ok = renderConfig(config, writer);
+  }
+  ok = !fclose(out) && ok;
+  if(!ok)
+    fprintf(stderr, "%s: write error\n", path.c_str());
+  return ok;
+}
+
+#endif /* _RENDER_H_ */
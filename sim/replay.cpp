@@ -0,0 +1,230 @@
+/*
+  Replays an input log written by a SEQUENCER_INPUT_LOG build (see
+  InputLog.h) through the firmware, against the simulated peripherals.
+  Clock and reset edges drive the interrupt inputs at their recorded
+  times; switch and control records set the inputs and run loop(), which
+  is all that loop() does that affects the outputs. The log is read as a
+  stream, and time jumps from one record to the next, so a long session
+  replays at full speed.
+
+  Prints the same checksum of the output port after every clock edge as
+  the simulation runner, and with -v every clock edge and the outputs.
+  Fails if the firmware dropped edges from the log, whose replay then
+  differs from the session.
+
+  usage: replay [-v] input.log
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <avr/io.h>
+#include "sim.h"
+#include "device.h"
+#include "adc_freerunner.h"
+#include "InputLog.h"
+
+void setup();
+void loop();
+void updateControls();
+void reset();
+
+struct Record {
+  uint8_t type;
+  uint8_t flags;
+  uint64_t time; // ticks since the start of the log
+  uint8_t switches;
+  uint8_t changed;
+  int16_t deltas[ADC_CHANNELS];
+  uint32_t dropped;
+};
+
+static FILE* in;
+static uint64_t ticks;
+
+static bool readVarint(uint32_t& value){
+  value = 0;
+  for(uint8_t shift=0; shift<35; shift+=7){
+    int c = getc(in);
+    if(c == EOF)
+      return false;
+    value |= (uint32_t)(c & 0x7f) << shift;
+    if(!(c & 0x80))
+      return true;
+  }
+  return false;
+}
+
+static bool readRecord(Record& r){
+  int c = getc(in);
+  uint32_t delta;
+  if(c == EOF || !readVarint(delta))
+    return false;
+  r.type = c >> 4;
+  r.flags = c & 0x0f;
+  ticks += delta;
+  r.time = ticks;
+  switch(r.type){
+  case INPUT_LOG_SWITCHES:
+    if((c = getc(in)) == EOF)
+      return false;
+    r.switches = c;
+    break;
+  case INPUT_LOG_CONTROLS:
+    if((c = getc(in)) == EOF)
+      return false;
+    r.changed = c;
+    for(uint8_t i=0; i<ADC_CHANNELS; ++i){
+      uint32_t zigzag;
+      if((r.changed & _BV(i)) && !readVarint(zigzag))
+	return false;
+      r.deltas[i] = (r.changed & _BV(i)) ? (int16_t)((zigzag >> 1) ^ -(zigzag & 1)) : 0;
+    }
+    break;
+  case INPUT_LOG_DROPPED:
+    if(!readVarint(r.dropped))
+      return false;
+    break;
+  case INPUT_LOG_CLOCK:
+  case INPUT_LOG_RESET:
+  case INPUT_LOG_BOOT:
+    break;
+  default:
+    fprintf(stderr, "replay: unknown record type %d\n", r.type);
+    exit(1);
+  }
+  return true;
+}
+
+static void setChained(bool chained){
+  if(chained)
+    sim_portB.input &= ~_BV(SEQUENCER_CHAINED_SWITCH_PIN);
+  else
+    sim_portB.input |= _BV(SEQUENCER_CHAINED_SWITCH_PIN);
+}
+
+/* the switches are active low */
+static void setSwitches(uint8_t state){
+  SimPort* port = &sim_portD;
+  port->input |= _BV(SEQUENCER_TRIGGER_SWITCH_PIN_A) | _BV(SEQUENCER_ALTERNATE_SWITCH_PIN_A) |
+    _BV(SEQUENCER_TRIGGER_SWITCH_PIN_B) | _BV(SEQUENCER_ALTERNATE_SWITCH_PIN_B);
+  if(state & INPUT_LOG_SWITCH_TRIGGER_A)
+    port->input &= ~_BV(SEQUENCER_TRIGGER_SWITCH_PIN_A);
+  if(state & INPUT_LOG_SWITCH_ALTERNATE_A)
+    port->input &= ~_BV(SEQUENCER_ALTERNATE_SWITCH_PIN_A);
+  if(state & INPUT_LOG_SWITCH_TRIGGER_B)
+    port->input &= ~_BV(SEQUENCER_TRIGGER_SWITCH_PIN_B);
+  if(state & INPUT_LOG_SWITCH_ALTERNATE_B)
+    port->input &= ~_BV(SEQUENCER_ALTERNATE_SWITCH_PIN_B);
+  setChained(state & INPUT_LOG_SWITCH_CHAINED);
+}
+
+int main(int argc, char** argv){
+  bool verbose = argc > 2 && !strcmp(argv[1], "-v");
+  const char* file = argv[argc-1];
+  if(argc < 2 || !(in = fopen(file, "rb"))){
+    fprintf(stderr, "usage: replay [-v] input.log\n");
+    return 1;
+  }
+  char magic[4];
+  uint32_t cyclesPerTick;
+  // version 1 differs only in having no DROPPED records
+  int version = 0;
+  if(fread(magic, 1, 4, in) != 4 || memcmp(magic, "EUIN", 4) ||
+     (version = getc(in)) < 1 || version > INPUT_LOG_VERSION || !readVarint(cyclesPerTick)){
+    fprintf(stderr, "replay: %s is not an input log of version 1 to %d\n", file, INPUT_LOG_VERSION);
+    return 1;
+  }
+
+  sim_reset();
+  sim_erase_eeprom();
+  sim_drive(sim_portD, SEQUENCER_CLOCK_PIN, true); // clock low
+  sim_drive(sim_portD, SEQUENCER_RESET_PIN, true); // reset low
+
+  uint32_t checksum = 2166136261UL;
+  unsigned long records = 0, edges = 0, dropped = 0;
+  bool booted = false;
+  bool dirty = false;
+  Record r, next;
+  bool more = readRecord(next);
+  clock_t start = clock();
+  while(more){
+    r = next;
+    more = readRecord(next);
+    records++;
+    uint64_t cycle = r.time * cyclesPerTick;
+    if(cycle > sim_cycles)
+      sim_run(cycle - sim_cycles);
+    switch(r.type){
+    case INPUT_LOG_BOOT:
+      setup();
+      // the control values come from the log
+      ADCSRA = 0;
+      if(r.flags & 1){
+	// as setup() does after restoring a preset
+	updateControls();
+	reset();
+      }
+      booted = true;
+      dirty = false;
+      break;
+    case INPUT_LOG_CLOCK: {
+      setChained(r.flags & INPUT_LOG_CHAINED);
+      bool level = !(r.flags & INPUT_LOG_CLOCK_HIGH); // inverted input
+      if(!(sim_portD.input & _BV(SEQUENCER_CLOCK_PIN)) == !level)
+	EIFR |= _BV(INTF1); // the handler ran without a change of level
+      sim_drive(sim_portD, SEQUENCER_CLOCK_PIN, level);
+      uint8_t outputs = PORTB;
+      checksum = (checksum ^ outputs) * 16777619UL;
+      edges++;
+      if(verbose)
+	printf("%llu %s%s outputs %02x\n", (unsigned long long)r.time,
+	       r.flags & INPUT_LOG_CLOCK_HIGH ? "rise" : "fall",
+	       r.flags & INPUT_LOG_CHAINED ? " chained" : "", outputs);
+      break;
+    }
+    case INPUT_LOG_RESET:
+      if(r.flags & 1){
+	// the handler waits for the release, which is the next record
+	uint64_t release = sim_cycles + 1;
+	if(more && next.type == INPUT_LOG_RESET && !(next.flags & 1))
+	  release = next.time * cyclesPerTick;
+	sim_schedule(release, sim_portD, SEQUENCER_RESET_PIN, true);
+	sim_drive(sim_portD, SEQUENCER_RESET_PIN, false);
+      }
+      break;
+    case INPUT_LOG_SWITCHES:
+      setSwitches(r.switches);
+      dirty = true;
+      break;
+    case INPUT_LOG_CONTROLS:
+      for(uint8_t i=0; i<ADC_CHANNELS; ++i)
+	adc_values[i] += r.deltas[i];
+      dirty = true;
+      break;
+    case INPUT_LOG_DROPPED:
+      dropped += r.dropped;
+      if(verbose)
+	printf("%llu dropped %lu\n", (unsigned long long)r.time, (unsigned long)r.dropped);
+      break;
+    }
+    // a SWITCHES record followed by CONTROLS is one pass of loop()
+    if(booted && dirty && !(r.type == INPUT_LOG_SWITCHES && more && next.type == INPUT_LOG_CONTROLS)){
+      loop();
+      dirty = false;
+    }
+  }
+  double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+  printf("records %lu\n", records);
+  printf("edges %lu\n", edges);
+  printf("simulated %.3fs\n", (double)sim_cycles / F_CPU);
+  printf("elapsed %.3fs\n", seconds);
+  printf("checksum %08lx\n", (unsigned long)checksum);
+  if(dropped){
+    printf("dropped %lu\n", dropped);
+    fprintf(stderr, "replay: %s is incomplete, the firmware dropped %lu edges\n", file, dropped);
+    return 1;
+  }
+  return 0;
+}
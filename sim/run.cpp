@@ -0,0 +1,116 @@
+/*
+  Runs the firmware natively against the simulated peripherals:
+  setup(), then loop() interleaved with clock edges, knob and switch
+  changes and reset pulses. Prints the simulation speed and a checksum of the output
+  port after every clock edge, which can be compared between builds.
+
+  usage: sim [-t trace.vcd] [edges] [cycles per half clock period] [seed] [serial output]
+  A build with SEQUENCER_INPUT_LOG writes its input log to the serial
+  output file, which the replay tool plays back to the same checksum.
+  A build with SEQUENCER_TRACE writes a VCD waveform of the inputs, LEDs,
+  gates and sequencer state with -t, see trace.h.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <avr/io.h>
+#include "sim.h"
+
+void setup();
+void loop();
+#ifdef SEQUENCER_TRACE
+void traceOpen(FILE* out);
+void traceClose();
+#endif
+
+#define SIM_LOOP_CYCLES          2000
+#define SIM_KNOB_INTERVAL        1000
+#define SIM_SWITCH_INTERVAL      5000
+#define SIM_RESET_INTERVAL       9973
+#define SIM_RESET_LENGTH         1000
+
+int main(int argc, char** argv){
+#ifdef SEQUENCER_TRACE
+  FILE* trace = NULL;
+#endif
+  if(argc > 2 && !strcmp(argv[1], "-t")){
+#ifdef SEQUENCER_TRACE
+    if(!(trace = fopen(argv[2], "wb"))){
+      fprintf(stderr, "sim: cannot write %s\n", argv[2]);
+      return 1;
+    }
+#else
+    fprintf(stderr, "sim: -t needs a build with SEQUENCER_TRACE\n");
+    return 1;
+#endif
+    argc -= 2;
+    argv += 2;
+  }
+  unsigned long edges = argc > 1 ? strtoul(argv[1], NULL, 0) : 10000000;
+  uint32_t halfPeriod = argc > 2 ? strtoul(argv[2], NULL, 0) : 4000;
+  unsigned int seed = argc > 3 ? strtoul(argv[3], NULL, 0) : 1;
+  FILE* serial = NULL;
+  if(argc > 4 && !(serial = fopen(argv[4], "wb"))){
+    fprintf(stderr, "sim: cannot write %s\n", argv[4]);
+    return 1;
+  }
+  sim_serial_output(serial);
+  srand(seed);
+  sim_reset();
+  for(uint8_t i=0; i<8; ++i)
+    sim_analog(i, rand() & 1023);
+  sim_drive(sim_portD, PORTD2, true); // reset low
+  sim_drive(sim_portD, PORTD3, true); // clock low
+  for(uint8_t pin=PORTD4; pin<=PORTD7; ++pin)
+    sim_drive(sim_portD, pin, rand() & 1);
+#ifdef SEQUENCER_TRACE
+  if(trace)
+    traceOpen(trace);
+#endif
+  setup();
+
+  uint32_t checksum = 2166136261UL;
+  unsigned long gates = 0;
+  clock_t start = clock();
+  for(unsigned long i=0; i<edges; ++i){
+    // inputs are inverted: driving the pin low is a high clock
+    bool high = !(i & 1);
+    sim_drive(sim_portD, PORTD3, !high);
+    uint8_t outputs = PORTB;
+    checksum = (checksum ^ outputs) * 16777619UL;
+    if(high)
+      gates += !(outputs & _BV(PORTB0));
+    for(uint32_t t=0; t<halfPeriod; t+=SIM_LOOP_CYCLES){
+      loop();
+      sim_run(SIM_LOOP_CYCLES);
+    }
+    if(i % SIM_KNOB_INTERVAL == 0)
+      sim_analog(rand() % 8, rand() & 1023);
+    if(i % SIM_SWITCH_INTERVAL == 0)
+      sim_drive(sim_portD, PORTD4 + rand() % 4, rand() & 1);
+    if(i % SIM_SWITCH_INTERVAL == SIM_SWITCH_INTERVAL/2)
+      sim_drive(sim_portB, PORTB2, rand() & 1);
+    if(i % SIM_RESET_INTERVAL == SIM_RESET_INTERVAL-1){
+      sim_schedule(sim_cycles + SIM_RESET_LENGTH, sim_portD, PORTD2, true);
+      sim_drive(sim_portD, PORTD2, false);
+    }
+  }
+  double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+  printf("edges %lu\n", edges);
+  printf("simulated %.3fs\n", (double)sim_cycles / F_CPU);
+  printf("elapsed %.3fs\n", seconds);
+  printf("edges/s %.0f\n", edges / seconds);
+  printf("gates %lu\n", gates);
+  printf("checksum %08lx\n", (unsigned long)checksum);
+#ifdef SEQUENCER_TRACE
+  if(trace){
+    traceClose();
+    fclose(trace);
+  }
+#endif
+  if(serial)
+    fclose(serial);
+  return 0;
+}
@@ -0,0 +1,112 @@
+/*
+  Host implementation of serial.h for the simulation.
+  Output goes to stdout or the file given to sim_serial_output(), input
+  comes from sim_serial_input().
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "serial.h"
+
+#define RX_BUFFER_SIZE 128
+
+static unsigned char rx_buffer[RX_BUFFER_SIZE];
+static int rx_buffer_head = 0;
+static int rx_buffer_tail = 0;
+static FILE* output;
+
+void sim_serial_output(FILE* out)
+{
+	output = out;
+}
+
+void sim_serial_input(const char* s)
+{
+	while(*s){
+		int i = (rx_buffer_head + 1) % RX_BUFFER_SIZE;
+		if(i == rx_buffer_tail)
+			break;
+		rx_buffer[rx_buffer_head] = *s++;
+		rx_buffer_head = i;
+	}
+}
+
+void beginSerial(long baud)
+{
+}
+
+void serialWrite(unsigned char c)
+{
+	putc(c, output ? output : stdout);
+}
+
+int serialAvailable()
+{
+	return (RX_BUFFER_SIZE + rx_buffer_head - rx_buffer_tail) % RX_BUFFER_SIZE;
+}
+
+int serialRead()
+{
+	if(rx_buffer_head == rx_buffer_tail)
+		return -1;
+	unsigned char c = rx_buffer[rx_buffer_tail];
+	rx_buffer_tail = (rx_buffer_tail + 1) % RX_BUFFER_SIZE;
+	return c;
+}
+
+void serialFlush()
+{
+	rx_buffer_head = rx_buffer_tail;
+}
+
+void printByte(unsigned char c)
+{
+	serialWrite(c);
+}
+
+void printNewline()
+{
+	printByte('\n');
+}
+
+void printString(const char *s)
+{
+	fputs(s, output ? output : stdout);
+}
+
+void printIntegerInBase(unsigned long n, unsigned long base)
+{
+	char buf[8 * sizeof(long) + 1];
+	int i = sizeof(buf) - 1;
+	buf[i] = 0;
+	do {
+		unsigned long digit = n % base;
+		buf[--i] = digit < 10 ? '0' + digit : 'A' + digit - 10;
+		n /= base;
+	} while(n);
+	printString(buf + i);
+}
+
+void printInteger(long n)
+{
+	if(n < 0){
+		printByte('-');
+		n = -n;
+	}
+	printIntegerInBase(n, 10);
+}
+
+void printHex(unsigned long n)
+{
+	printIntegerInBase(n, 16);
+}
+
+void printOctal(unsigned long n)
+{
+	printIntegerInBase(n, 8);
+}
+
+void printBinary(unsigned long n)
+{
+	printIntegerInBase(n, 2);
+}
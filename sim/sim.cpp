@@ -0,0 +1,312 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "sim.h"
+
+/* cycles taken by a busy-waiting read of an input pin */
+#define SIM_POLL_CYCLES          3
+/* give up on a busy wait that no scheduled input can end */
+#define SIM_POLL_LIMIT           (F_CPU*10ULL)
+/* 13 ADC clock cycles per conversion */
+#define SIM_ADC_CONVERSION       13
+/* 3.4ms per EEPROM byte */
+#define SIM_EEPROM_WRITE_CYCLES  (F_CPU/1000*34/10)
+#define SIM_SCHEDULE_SIZE        64
+
+thread_local SimPort sim_portB = { 0, 0, 0xff, SimPin(&sim_portB) };
+thread_local SimPort sim_portC = { 0, 0, 0xff, SimPin(&sim_portC) };
+thread_local SimPort sim_portD = { 0, 0, 0xff, SimPin(&sim_portD) };
+
+thread_local volatile uint8_t sim_EICRA, sim_EIMSK, sim_EIFR;
+thread_local volatile uint8_t sim_ADMUX, sim_ADCSRA, sim_ADCL, sim_ADCH;
+thread_local volatile uint8_t sim_EECR, sim_EEDR;
+thread_local volatile uint16_t sim_EEAR;
+thread_local volatile uint8_t sim_TCCR1A, sim_TCCR1B, sim_TIMSK1, sim_TIFR1;
+thread_local SimTimer sim_TCNT1;
+
+static constexpr SimEeprom erased(){
+  SimEeprom eeprom = {};
+  for(uint16_t i=0; i<SIM_EEPROM_SIZE; ++i)
+    eeprom.bytes[i] = 0xff;
+  return eeprom;
+}
+
+thread_local SimEeprom sim_eeprom = erased();
+thread_local uint64_t sim_cycles;
+thread_local bool sim_interrupts;
+thread_local void (*sim_trace)();
+
+static thread_local uint16_t analog[8];
+static thread_local bool converting;
+static thread_local uint8_t convertingChannel;
+static thread_local uint64_t conversionDone;
+static thread_local bool writing;
+static thread_local uint64_t writeDone;
+static thread_local uint16_t timerValue;
+static thread_local uint64_t timerStart;
+static thread_local uint64_t timerWraps;
+
+struct SimEvent {
+  uint64_t cycle;
+  SimPort* port;
+  uint8_t pin;
+  bool level;
+};
+
+static thread_local SimEvent schedule[SIM_SCHEDULE_SIZE];
+static thread_local uint8_t scheduled;
+
+
+/* default handlers for vectors the firmware does not use */
+__attribute__((weak)) void INT0_vect(){}
+__attribute__((weak)) void INT1_vect(){}
+__attribute__((weak)) void TIMER1_OVF_vect(){}
+__attribute__((weak)) void ADC_vect(){}
+__attribute__((weak)) void EE_READY_vect(){
+  EECR &= ~_BV(EERIE);
+}
+
+static void poll();
+
+SimPin::operator uint8_t() const {
+  if(!sim_interrupts)
+    poll();
+  return level();
+}
+
+uint8_t SimPin::level() const {
+  return (port->port & port->ddr) | (port->input & ~port->ddr);
+}
+
+SimPin& SimPin::operator=(uint8_t value){
+  port->input = value;
+  return *this;
+}
+
+static uint16_t timerPrescaler(){
+  static const uint16_t prescalers[] = { 0, 1, 8, 64, 256, 1024, 0, 0 };
+  return prescalers[TCCR1B & 7];
+}
+
+SimTimer::operator uint16_t() const {
+  uint16_t prescaler = timerPrescaler();
+  if(!prescaler)
+    return timerValue;
+  return timerValue + (uint16_t)((sim_cycles - timerStart) / prescaler);
+}
+
+SimTimer& SimTimer::operator=(uint16_t value){
+  timerValue = value;
+  timerStart = sim_cycles;
+  timerWraps = 0;
+  return *this;
+}
+
+/* cycle at which the timer next overflows, or 0 if it is stopped */
+static uint64_t timerOverflow(){
+  uint16_t prescaler = timerPrescaler();
+  if(!prescaler)
+    return 0;
+  return timerStart + (((timerWraps + 1) << 16) - timerValue) * prescaler;
+}
+
+void sim_cli(){
+  sim_interrupts = false;
+}
+
+void sim_sei(){
+  sim_interrupts = true;
+  sim_dispatch();
+}
+
+void sim_reset(){
+  sim_portB.port = sim_portB.ddr = 0;
+  sim_portC.port = sim_portC.ddr = 0;
+  sim_portD.port = sim_portD.ddr = 0;
+  sim_portB.input = sim_portC.input = sim_portD.input = 0xff;
+  sim_EICRA = sim_EIMSK = sim_EIFR = 0;
+  sim_ADMUX = sim_ADCSRA = sim_ADCL = sim_ADCH = 0;
+  sim_EECR = sim_EEDR = 0;
+  sim_EEAR = 0;
+  sim_TCCR1A = sim_TCCR1B = sim_TIMSK1 = sim_TIFR1 = 0;
+  sim_cycles = 0;
+  sim_interrupts = false;
+  converting = writing = false;
+  timerValue = 0;
+  timerStart = 0;
+  timerWraps = 0;
+  scheduled = 0;
+}
+
+void sim_erase_eeprom(){
+  memset(sim_eeprom.bytes, 0xff, sizeof(sim_eeprom.bytes));
+}
+
+static void edge(uint8_t interrupt, bool before, bool after){
+  uint8_t sense = (EICRA >> (interrupt*2)) & 3;
+  bool trigger;
+  switch(sense){
+  case 0: // low level
+    trigger = !after;
+    break;
+  case 1: // any change
+    trigger = before != after;
+    break;
+  case 2: // falling edge
+    trigger = before && !after;
+    break;
+  default: // rising edge
+    trigger = !before && after;
+    break;
+  }
+  if(trigger)
+    EIFR |= _BV(interrupt);
+}
+
+static void apply(SimPort& port, uint8_t pin, bool level){
+  bool before = port.input & _BV(pin);
+  if(level)
+    port.input |= _BV(pin);
+  else
+    port.input &= ~_BV(pin);
+  if(&port == &sim_portD && (pin == PORTD2 || pin == PORTD3))
+    edge(pin - PORTD2, before, level);
+  if(sim_trace)
+    sim_trace();
+}
+
+void sim_drive(SimPort& port, uint8_t pin, bool level){
+  apply(port, pin, level);
+  sim_dispatch();
+}
+
+void sim_schedule(uint64_t cycle, SimPort& port, uint8_t pin, bool level){
+  if(scheduled == SIM_SCHEDULE_SIZE){
+    fprintf(stderr, "sim: too many scheduled inputs\n");
+    abort();
+  }
+  uint8_t i = scheduled++;
+  for(; i > 0 && schedule[i-1].cycle > cycle; --i)
+    schedule[i] = schedule[i-1];
+  SimEvent event = { cycle, &port, pin, level };
+  schedule[i] = event;
+}
+
+void sim_analog(uint8_t channel, uint16_t value){
+  analog[channel & 7] = value;
+}
+
+static void startConversion(){
+  static const uint8_t prescalers[] = { 2, 2, 4, 8, 16, 32, 64, 128 };
+  converting = true;
+  convertingChannel = ADMUX & 7;
+  conversionDone = sim_cycles + (uint32_t)SIM_ADC_CONVERSION * prescalers[ADCSRA & 7];
+}
+
+/* brings the peripherals up to the current time */
+static void update(){
+  while(scheduled && schedule[0].cycle <= sim_cycles){
+    SimEvent event = schedule[0];
+    memmove(schedule, schedule+1, --scheduled * sizeof(SimEvent));
+    apply(*event.port, event.pin, event.level);
+  }
+  if((ADCSRA & _BV(ADEN)) && (ADCSRA & _BV(ADSC)) && !converting)
+    startConversion();
+  if(converting && sim_cycles >= conversionDone){
+    uint16_t value = analog[convertingChannel];
+    ADCL = value & 0xff;
+    ADCH = value >> 8;
+    ADCSRA |= _BV(ADIF);
+    converting = false;
+    if(ADCSRA & _BV(ADATE))
+      startConversion();
+    else
+      ADCSRA &= ~_BV(ADSC);
+  }
+  if((EECR & _BV(EEPE)) && !writing){
+    if(EECR & _BV(EEMPE))
+      sim_eeprom.bytes[EEAR & E2END] = EEDR;
+    EECR &= ~_BV(EEMPE);
+    writing = true;
+    writeDone = sim_cycles + SIM_EEPROM_WRITE_CYCLES;
+  }
+  if(writing && sim_cycles >= writeDone){
+    EECR &= ~_BV(EEPE);
+    writing = false;
+  }
+  uint64_t overflow = timerOverflow();
+  if(overflow && sim_cycles >= overflow){
+    timerWraps = (timerValue + (sim_cycles - timerStart) / timerPrescaler()) >> 16;
+    TIFR1 |= _BV(TOV1);
+  }
+}
+
+static void poll(){
+  static thread_local uint64_t polling, last;
+  // only back to back reads are a busy wait
+  if(sim_cycles != last)
+    polling = 0;
+  sim_cycles += SIM_POLL_CYCLES;
+  last = sim_cycles;
+  update();
+  if(scheduled){
+    polling = 0;
+  }else if((polling += SIM_POLL_CYCLES) > SIM_POLL_LIMIT){
+    fprintf(stderr, "sim: busy wait on input that never changes\n");
+    abort();
+  }
+}
+
+static inline void call(void (*vector)()){
+  sim_interrupts = false;
+  vector();
+  sim_interrupts = true;
+  if(sim_trace)
+    sim_trace();
+}
+
+void sim_dispatch(){
+  while(sim_interrupts){
+    update();
+    uint8_t external = EIFR & EIMSK;
+    if(external & _BV(INT0)){
+      EIFR &= ~_BV(INTF0);
+      call(INT0_vect);
+    }else if(external & _BV(INT1)){
+      EIFR &= ~_BV(INTF1);
+      call(INT1_vect);
+    }else if((TIFR1 & _BV(TOV1)) && (TIMSK1 & _BV(TOIE1))){
+      TIFR1 &= ~_BV(TOV1);
+      call(TIMER1_OVF_vect);
+    }else if((ADCSRA & _BV(ADIF)) && (ADCSRA & _BV(ADIE))){
+      ADCSRA &= ~_BV(ADIF);
+      call(ADC_vect);
+    }else if((EECR & _BV(EERIE)) && !(EECR & _BV(EEPE))){
+      call(EE_READY_vect);
+    }else{
+      break;
+    }
+  }
+}
+
+void sim_run(uint32_t cycles){
+  uint64_t end = sim_cycles + cycles;
+  while(sim_cycles < end){
+    uint64_t next = end;
+    if(scheduled && schedule[0].cycle < next)
+      next = schedule[0].cycle;
+    if(converting && conversionDone < next)
+      next = conversionDone;
+    if(writing && writeDone < next)
+      next = writeDone;
+    uint64_t overflow = timerOverflow();
+    if(overflow && (TIMSK1 & _BV(TOIE1)) && overflow < next)
+      next = overflow;
+    if(next > sim_cycles)
+      sim_cycles = next;
+    update();
+    sim_dispatch();
+  }
+}
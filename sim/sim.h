@@ -0,0 +1,113 @@
+#ifndef _SIM_H_
+#define _SIM_H_
+
+/**
+   Host simulation of the ATmega168/328 peripherals used by the firmware.
+   Time is counted in CPU cycles and only advances in sim_run(), or while
+   an interrupt handler busy-waits on an input pin. Interrupt handlers run
+   to completion in zero time, one at a time, in vector priority order.
+   All simulation state is thread local, so each thread can run its own
+   simulated device.
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+
+struct SimPort;
+
+/* the PINx register of a port */
+class SimPin {
+public:
+  constexpr SimPin(SimPort* p) : port(p) {}
+  operator uint8_t() const;
+  /* reads the pins without advancing time, for tracing */
+  uint8_t level() const;
+  SimPin& operator=(uint8_t value);
+  SimPin& operator|=(uint8_t value){ return *this = *this | value; }
+  SimPin& operator&=(uint8_t value){ return *this = *this & value; }
+  SimPin& operator^=(uint8_t value){ return *this = *this ^ value; }
+private:
+  SimPort* port;
+};
+
+struct SimPort {
+  volatile uint8_t port;
+  volatile uint8_t ddr;
+  volatile uint8_t input; // levels driven on the pins from outside
+  SimPin pin;
+};
+
+/* the TCNT1 register, counting CPU cycles divided by the prescaler */
+class SimTimer {
+public:
+  operator uint16_t() const;
+  SimTimer& operator=(uint16_t value);
+};
+
+extern thread_local SimPort sim_portB;
+extern thread_local SimPort sim_portC;
+extern thread_local SimPort sim_portD;
+
+extern thread_local volatile uint8_t sim_EICRA, sim_EIMSK, sim_EIFR;
+extern thread_local volatile uint8_t sim_ADMUX, sim_ADCSRA, sim_ADCL, sim_ADCH;
+extern thread_local volatile uint8_t sim_EECR, sim_EEDR;
+extern thread_local volatile uint16_t sim_EEAR;
+extern thread_local volatile uint8_t sim_TCCR1A, sim_TCCR1B, sim_TIMSK1, sim_TIFR1;
+extern thread_local SimTimer sim_TCNT1;
+
+#define SIM_EEPROM_SIZE 1024
+
+struct SimEeprom {
+  uint8_t bytes[SIM_EEPROM_SIZE];
+};
+
+extern thread_local SimEeprom sim_eeprom;
+
+/* elapsed CPU cycles */
+extern thread_local uint64_t sim_cycles;
+
+/* if set, called after every input change and interrupt handler */
+extern thread_local void (*sim_trace)();
+
+/* interrupts globally enabled */
+extern thread_local bool sim_interrupts;
+
+void sim_cli();
+void sim_sei();
+
+/* resets registers and time, but keeps the EEPROM contents */
+void sim_reset();
+
+/* sets every EEPROM byte to 0xff */
+void sim_erase_eeprom();
+
+/* drives an input pin and raises INT0 or INT1 on a matching edge */
+void sim_drive(SimPort& port, uint8_t pin, bool level);
+
+/* drives an input pin at a later time */
+void sim_schedule(uint64_t cycle, SimPort& port, uint8_t pin, bool level);
+
+/* sets the voltage on an analog input, 0 to 1023 */
+void sim_analog(uint8_t channel, uint16_t value);
+
+/* advances time, completing ADC conversions, EEPROM writes, timer overflows and scheduled inputs */
+void sim_run(uint32_t cycles);
+
+/* runs any enabled and pending interrupt handlers */
+void sim_dispatch();
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* queues characters to be received by the serial port */
+void sim_serial_input(const char* s);
+
+/* writes what is sent on the serial port to a file instead of stdout */
+void sim_serial_output(FILE* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SIM_H_ */
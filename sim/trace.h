@@ -0,0 +1,111 @@
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+/**
+   Trace points of an instrumented host build (SEQUENCER_TRACE), included
+   by GateSequencer.h. traceOpen() streams the clock and reset inputs, the
+   LEDs, and the gate, step and mode of every GateSequencer (named by its
+   output pin) and the segment of the chained sequencer to a VCD file.
+   Pins are sampled after every input change and interrupt handler, so
+   the trace has the exact cycle of every change.
+*/
+
+#include <stdio.h>
+#include <avr/io.h>
+#include "sim.h"
+#include "vcd.h"
+
+#define TRACE_MAX_CHANNELS       4
+#define TRACE_PS_PER_CYCLE       (1000000000000ULL / F_CPU)
+
+#define SEQUENCER_TRACE_CHANNEL(output)     traceChannel(output)
+#define SEQUENCER_TRACE_STEP(output, pos)   traceState(output, 1, pos)
+#define SEQUENCER_TRACE_MODE(output, mode)  traceState(output, 2, mode)
+#define SEQUENCER_TRACE_SEGMENT(index)      traceSegment(index)
+
+static VcdWriter* tracer;
+static uint8_t traceOutputs[TRACE_MAX_CHANNELS];
+static char traceScopes[TRACE_MAX_CHANNELS][8];
+static uint8_t traceChannels;
+static uint8_t traceFirst;
+
+/* registers a GateSequencer, before traceOpen() */
+void traceChannel(uint8_t output){
+  if(traceChannels < TRACE_MAX_CHANNELS){
+    snprintf(traceScopes[traceChannels], sizeof(traceScopes[0]), "seq%d", output);
+    traceOutputs[traceChannels++] = output;
+  }
+}
+
+static inline uint64_t traceTime(){
+  return sim_cycles * TRACE_PS_PER_CYCLE;
+}
+
+/* variables: clock, reset, [chained], led a, led b, [led c], [segment],
+   then gate, step and mode of each channel */
+static void traceSample(){
+  uint64_t t = traceTime();
+  uint8_t i = 0;
+  tracer->set(i++, t, !(SEQUENCER_CLOCK_PINS.level() & _BV(SEQUENCER_CLOCK_PIN)));
+  tracer->set(i++, t, !(SEQUENCER_RESET_PINS.level() & _BV(SEQUENCER_RESET_PIN)));
+#ifdef SEQUENCER_CHAINED_SWITCH_PIN
+  tracer->set(i++, t, !(SEQUENCER_CHAINED_SWITCH_PINS.level() & _BV(SEQUENCER_CHAINED_SWITCH_PIN)));
+#endif
+  tracer->set(i++, t, (SEQUENCER_LEDS_PORT >> SEQUENCER_LED_A_PIN) & 1);
+  tracer->set(i++, t, (SEQUENCER_LEDS_PORT >> SEQUENCER_LED_B_PIN) & 1);
+#ifdef SEQUENCER_LED_C_PIN
+  tracer->set(i++, t, (SEQUENCER_LEDS_PORT >> SEQUENCER_LED_C_PIN) & 1);
+#endif
+  for(uint8_t c=0; c<traceChannels; ++c)
+    tracer->set(traceFirst + c*3, t, !((SEQUENCER_OUTPUT_PORT >> traceOutputs[c]) & 1));
+}
+
+void traceState(uint8_t output, uint8_t offset, uint8_t value){
+  if(!tracer)
+    return;
+  for(uint8_t c=0; c<traceChannels; ++c)
+    if(traceOutputs[c] == output)
+      tracer->set(traceFirst + c*3 + offset, traceTime(), value);
+}
+
+void traceSegment(uint8_t index){
+#ifdef SEQUENCER_CHAINED_SWITCH_PIN
+  if(tracer)
+    tracer->set(traceFirst - 1, traceTime(), index);
+#endif
+}
+
+void traceOpen(FILE* out){
+  tracer = new VcdWriter(out, "1 ps");
+  tracer->add("sequencer", "clock", 1);
+  tracer->add("sequencer", "reset", 1);
+#ifdef SEQUENCER_CHAINED_SWITCH_PIN
+  tracer->add("sequencer", "chained", 1);
+#endif
+  tracer->add("sequencer", "led_a", 1);
+  tracer->add("sequencer", "led_b", 1);
+#ifdef SEQUENCER_LED_C_PIN
+  tracer->add("sequencer", "led_c", 1);
+#endif
+#ifdef SEQUENCER_CHAINED_SWITCH_PIN
+  tracer->add("sequencer", "segment", 8);
+#endif
+  for(uint8_t c=0; c<traceChannels; ++c){
+    uint8_t gate = tracer->add(traceScopes[c], "gate", 1);
+    if(!c)
+      traceFirst = gate;
+    tracer->add(traceScopes[c], "step", 8);
+    tracer->add(traceScopes[c], "mode", 2);
+  }
+  tracer->begin();
+  sim_trace = traceSample;
+  traceSample();
+}
+
+void traceClose(){
+  sim_trace = NULL;
+  delete tracer;
+  tracer = NULL;
+}
+
+#endif /* _TRACE_H_ */
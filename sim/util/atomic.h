@@ -0,0 +1,36 @@
+#ifndef _SIM_UTIL_ATOMIC_H_
+#define _SIM_UTIL_ATOMIC_H_
+
+/**
+   Host replacement for <util/atomic.h>.
+   ATOMIC_BLOCK disables interrupts for the statement that follows and
+   restores the previous state afterwards, which dispatches any interrupt
+   that became pending in the meantime.
+*/
+
+#include "sim.h"
+
+class SimAtomic {
+public:
+  SimAtomic() : enabled(sim_interrupts), done(false) {
+    sim_cli();
+  }
+  ~SimAtomic(){
+    if(enabled)
+      sim_sei();
+  }
+  bool once(){
+    bool first = !done;
+    done = true;
+    return first;
+  }
+private:
+  bool enabled;
+  bool done;
+};
+
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_FORCEON
+#define ATOMIC_BLOCK(type) for(SimAtomic sim_atomic; sim_atomic.once(); )
+
+#endif /* _SIM_UTIL_ATOMIC_H_ */
@@ -0,0 +1,129 @@
+#ifndef _VCD_H_
+#define _VCD_H_
+
+/**
+   Streaming writer for Value Change Dump files, as read by GTKWave.
+   Variables are declared first, then values are set at non-decreasing
+   times; only changes are written, through a fixed buffer, so a trace
+   of any length runs in constant memory.
+*/
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <inttypes.h>
+
+#define VCD_MAX_VARIABLES        64
+#define VCD_BUFFER_SIZE          65536
+
+class VcdWriter {
+public:
+  VcdWriter(FILE* f, const char* ts) : out(f), timescale(ts), count(0), used(0),
+				       time(0), started(false) {}
+
+  ~VcdWriter(){
+    flush();
+  }
+
+  /* declares a variable in a scope, returns its index */
+  uint8_t add(const char* scope, const char* name, uint8_t width){
+    Variable& v = variables[count];
+    v.scope = scope;
+    v.name = name;
+    v.width = width;
+    v.value = 0;
+    v.known = false;
+    // identifiers are printable characters from '!'
+    uint8_t i = count;
+    char* id = v.id;
+    do {
+      *id++ = '!' + i % 94;
+      i /= 94;
+    } while(i);
+    *id = 0;
+    return count++;
+  }
+
+  /* writes the header, call once all variables are declared */
+  void begin(){
+    print("$timescale %s $end\n", timescale);
+    const char* scope = NULL;
+    for(uint8_t i=0; i<count; ++i){
+      Variable& v = variables[i];
+      if(!scope || strcmp(scope, v.scope)){
+	if(scope)
+	  print("$upscope $end\n");
+	print("$scope module %s $end\n", v.scope);
+	scope = v.scope;
+      }
+      print("$var wire %d %s %s $end\n", v.width, v.id, v.name);
+    }
+    if(scope)
+      print("$upscope $end\n");
+    print("$enddefinitions $end\n");
+  }
+
+  void set(uint8_t index, uint64_t t, uint32_t value){
+    Variable& v = variables[index];
+    if(v.known && v.value == value)
+      return;
+    if(!started || t != time){
+      print("#%" PRIu64 "\n", t);
+      time = t;
+      started = true;
+    }
+    v.value = value;
+    v.known = true;
+    if(v.width == 1){
+      print("%c%s\n", value ? '1' : '0', v.id);
+    }else{
+      char bits[33];
+      uint8_t n = 0;
+      for(int8_t b=v.width-1; b>=0; --b)
+	if(n || (value >> b) & 1 || !b)
+	  bits[n++] = '0' + ((value >> b) & 1);
+      bits[n] = 0;
+      print("b%s %s\n", bits, v.id);
+    }
+  }
+
+  void flush(){
+    if(used)
+      fwrite(buffer, 1, used, out);
+    used = 0;
+    fflush(out);
+  }
+
+private:
+  struct Variable {
+    const char* scope;
+    const char* name;
+    uint8_t width;
+    uint32_t value;
+    bool known;
+    char id[4];
+  };
+
+  __attribute__((format(printf, 2, 3)))
+  void print(const char* format, ...){
+    if(used > VCD_BUFFER_SIZE - 256){
+      fwrite(buffer, 1, used, out);
+      used = 0;
+    }
+    va_list args;
+    va_start(args, format);
+    used += vsnprintf(buffer + used, VCD_BUFFER_SIZE - used, format, args);
+    va_end(args);
+  }
+
+  FILE* out;
+  const char* timescale;
+  Variable variables[VCD_MAX_VARIABLES];
+  uint8_t count;
+  size_t used;
+  uint64_t time;
+  bool started;
+  char buffer[VCD_BUFFER_SIZE];
+};
+
+#endif /* _VCD_H_ */
@@ -0,0 +1,232 @@
+/*
+  Measures the execution time in CPU cycles of the clock (INT1), reset
+  (INT0), ADC and EEPROM interrupt handlers of the real AVR build of
+  Stoicheia, running under the simavr instruction level simulator.
+
+  Every combination of steps, fills, rotation, gate mode and chained mode
+  is dialled in through the simulated ADC inputs and switches, and the
+  sequencer is then clocked through its whole cycle. A handler is timed
+  from the cycle its vector is fetched up to and including its reti.
+  The reset handler busy-waits until reset is released; it is timed with
+  a reset pulse that is released immediately.
+
+  usage: wcet [-m mcu] [-f frequency] [-b budget] firmware.elf
+  Exits with status 2 if the worst case of the clock or ADC handlers
+  exceeds the budget in cycles.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_adc.h>
+
+#define STEPS_RANGE          16
+#define AVCC_MV              5000
+#define SETTLE_CYCLES        100000
+#define EDGE_CYCLES          2000
+#define RETI                 0x9518
+
+/* ATmega168/328 vector numbers */
+enum { VECTOR_INT0 = 1, VECTOR_INT1 = 2, VECTOR_ADC = 21, VECTOR_EE_READY = 22 };
+
+enum { MODE_DISABLED, MODE_TRIGGERING, MODE_ALTERNATING };
+static const char* modes[] = { "disabled", "triggering", "alternating" };
+
+typedef struct {
+  const char* name;
+  int vector;
+  uint64_t count;
+  avr_cycle_count_t min;
+  avr_cycle_count_t max;
+  double sum;
+  char worst[80];
+} isr_stats_t;
+
+static isr_stats_t stats[] = {
+  { "INT1_vect",     VECTOR_INT1 },
+  { "INT0_vect",     VECTOR_INT0 },
+  { "ADC_vect",      VECTOR_ADC },
+  { "EE_READY_vect", VECTOR_EE_READY },
+};
+#define ISR_COUNT (sizeof(stats)/sizeof(stats[0]))
+
+static avr_t* avr;
+static char input[80];
+
+/* nesting of interrupt handlers being timed */
+static int depth;
+static isr_stats_t* active[8];
+static avr_cycle_count_t entered[8];
+
+static void record(isr_stats_t* s, avr_cycle_count_t cycles){
+  if(!s->count || cycles < s->min)
+    s->min = cycles;
+  if(cycles > s->max){
+    s->max = cycles;
+    strcpy(s->worst, input);
+  }
+  s->sum += cycles;
+  s->count++;
+}
+
+/* executes one instruction, timing interrupt handlers */
+static void step(){
+  for(unsigned i=0; i<ISR_COUNT; ++i){
+    if(avr->pc == (avr_flashaddr_t)(stats[i].vector * avr->vector_size) && depth < 8){
+      active[depth] = &stats[i];
+      entered[depth++] = avr->cycle;
+      break;
+    }
+  }
+  uint16_t opcode = avr->flash[avr->pc] | (avr->flash[avr->pc+1] << 8);
+  int state = avr_run(avr);
+  if(state == cpu_Done || state == cpu_Crashed){
+    fprintf(stderr, "wcet: simulation stopped at pc 0x%04x\n", avr->pc);
+    exit(1);
+  }
+  if(opcode == RETI && depth > 0){
+    depth--;
+    record(active[depth], avr->cycle - entered[depth]);
+  }
+}
+
+static void run(avr_cycle_count_t cycles){
+  avr_cycle_count_t end = avr->cycle + cycles;
+  while(avr->cycle < end)
+    step();
+}
+
+static void drive(char port, int pin, int level){
+  avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(port), pin), level);
+}
+
+/* sets an analog input to read as the given 10-bit value */
+static void analog(int channel, int value){
+  if(value < 0)
+    value = 0;
+  if(value > 1023)
+    value = 1023;
+  avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_ADC_GETIRQ, ADC_IRQ_ADC0 + channel),
+		(value * AVCC_MV + AVCC_MV/2) / 1024);
+}
+
+/* inverse of the control scaling in GateSequencer and RotateController */
+static void dial(int fillChannel, int stepChannel, int rotateChannel,
+		 int steps, int fills, int rotation){
+  analog(stepChannel, (STEPS_RANGE - steps) * 64 + 32);
+  // the middle of the fill bucket; 0 fills is past the end stop of the
+  // knob, which clamps to 1023 and drives the knob's full scale end
+  analog(fillChannel, ((steps - fills) * 1024 + 512) / steps);
+  analog(rotateChannel, rotation * 64 + 32);
+}
+
+static void setMode(int trigger, int alternate, int mode){
+  // switches are active low
+  drive('D', trigger, mode != MODE_TRIGGERING);
+  drive('D', alternate, mode != MODE_ALTERNATING);
+}
+
+int main(int argc, char** argv){
+  const char* mcu = "atmega328p";
+  uint32_t frequency = 16000000;
+  avr_cycle_count_t budget = 0;
+  int opt;
+  while((opt = getopt(argc, argv, "m:f:b:")) != -1){
+    switch(opt){
+    case 'm':
+      mcu = optarg;
+      break;
+    case 'f':
+      frequency = strtoul(optarg, NULL, 0);
+      break;
+    case 'b':
+      budget = strtoull(optarg, NULL, 0);
+      break;
+    default:
+      fprintf(stderr, "usage: %s [-m mcu] [-f frequency] [-b budget] firmware.elf\n", argv[0]);
+      return 1;
+    }
+  }
+  if(optind >= argc){
+    fprintf(stderr, "usage: %s [-m mcu] [-f frequency] [-b budget] firmware.elf\n", argv[0]);
+    return 1;
+  }
+
+  elf_firmware_t firmware;
+  memset(&firmware, 0, sizeof(firmware));
+  if(elf_read_firmware(argv[optind], &firmware)){
+    fprintf(stderr, "wcet: cannot read %s\n", argv[optind]);
+    return 1;
+  }
+  avr = avr_make_mcu_by_name(mcu);
+  if(!avr){
+    fprintf(stderr, "wcet: unknown mcu %s\n", mcu);
+    return 1;
+  }
+  avr_init(avr);
+  avr_load_firmware(avr, &firmware);
+  avr->frequency = frequency;
+  avr->avcc = avr->aref = AVCC_MV;
+  avr->log = LOG_NONE;
+
+  // clock and reset low (inputs are inverted), all switches off
+  drive('D', 2, 1);
+  drive('D', 3, 1);
+  for(int pin=4; pin<8; ++pin)
+    drive('D', pin, 1);
+  drive('B', 2, 1);
+  run(SETTLE_CYCLES);
+
+  for(int chained=0; chained<2; ++chained){
+    drive('B', 2, !chained);
+    for(int mode=0; mode<3; ++mode){
+      setMode(4, 5, mode);
+      setMode(6, 7, mode);
+      for(int steps=1; steps<=STEPS_RANGE; ++steps){
+	for(int fills=0; fills<=steps; ++fills){
+	  for(int rotation=0; rotation<STEPS_RANGE; ++rotation){
+	    snprintf(input, sizeof(input), "steps %d fills %d rotation %d %s%s",
+		     steps, fills, rotation, modes[mode], chained ? " chained" : "");
+	    dial(0, 2, 4, steps, fills, rotation);
+	    // B gets the complementary length, to cover uneven chains
+	    int stepsB = STEPS_RANGE + 1 - steps;
+	    dial(1, 3, 5, stepsB, fills < stepsB ? fills : stepsB, rotation);
+	    run(SETTLE_CYCLES);
+	    for(int edge=0; edge<4*STEPS_RANGE; ++edge){
+	      drive('D', 3, edge & 1);
+	      run(EDGE_CYCLES);
+	    }
+	    drive('D', 3, 1);
+	  }
+	}
+	// a reset pulse per step count
+	drive('D', 2, 0);
+	run(100);
+	drive('D', 2, 1);
+	run(EDGE_CYCLES);
+      }
+    }
+  }
+
+  int failed = 0;
+  printf("%-14s %10s %8s %8s %10s  %s\n", "handler", "count", "min", "max", "mean", "worst case input");
+  for(unsigned i=0; i<ISR_COUNT; ++i){
+    isr_stats_t* s = &stats[i];
+    if(!s->count){
+      printf("%-14s %10d\n", s->name, 0);
+      continue;
+    }
+    printf("%-14s %10llu %8llu %8llu %10.1f  %s\n", s->name,
+	   (unsigned long long)s->count, (unsigned long long)s->min,
+	   (unsigned long long)s->max, s->sum / s->count, s->worst);
+    if(budget && (s->vector == VECTOR_INT1 || s->vector == VECTOR_ADC) && s->max > budget){
+      printf("%s exceeds budget of %llu cycles\n", s->name, (unsigned long long)budget);
+      failed = 1;
+    }
+  }
+  return failed ? 2 : 0;
+}